@@ -32,6 +32,107 @@ extern "C"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <stddef.h>
+#include <wchar.h>
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define STRING_BUILDER_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define STRING_BUILDER_SSE2 1
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#   include <tmmintrin.h>
+#   define STRING_BUILDER_SSSE3 1
+#endif
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+#ifndef _WIN32
+#   include <unistd.h>
+#   include <sys/uio.h>
+#else
+#   include <io.h>
+#endif
+
+#ifndef STRING_BUILDER_INLINE_CAPACITY
+#   define STRING_BUILDER_INLINE_CAPACITY 64 /**< Inline capacity of small_string_builder_t. */
+#endif
+
+#ifndef STRING_BUILDER_IOV_BATCH
+#   define STRING_BUILDER_IOV_BATCH 64 /**< Maximum number of segments passed to a single writev call. */
+#endif
+
+#ifndef STRING_BUILDER_ARENA_ALIGN
+#   define STRING_BUILDER_ARENA_ALIGN 16 /**< Alignment of arena allocations (a power of two, at least that of max_align_t). */
+#endif
+
+#ifndef STRING_BUILDER_JOIN_BATCH
+#   define STRING_BUILDER_JOIN_BATCH 64 /**< Number of null-terminated strings measured and joined at once. */
+#endif
+
+#ifndef STRING_BUILDER_INDENT_CAPACITY
+#   define STRING_BUILDER_INDENT_CAPACITY 128 /**< Number of indent characters an emitter copies at once. */
+#endif
+
+#ifndef STRING_BUILDER_SINK_MIN_CAPACITY
+#   define STRING_BUILDER_SINK_MIN_CAPACITY 64 /**< Smallest buffer of a streaming builder, enough for any single number. */
+#endif
+
+#ifndef STRING_BUILDER_ESCAPE_BLOCK
+#   define STRING_BUILDER_ESCAPE_BLOCK 4096 /**< Number of input bytes an escaping kernel sizes and reserves at once. */
+#endif
+
+#define STRING_BUILDER_FLAG_BORROWED 0x1u /**< The buffer is not owned by the builder. */
+#define STRING_BUILDER_FLAG_SINK_ERROR 0x2u /**< The sink failed, further output is discarded. */
+#define STRING_BUILDER_FLAG_VALIDATE_UTF8 0x4u /**< Appended text is validated as UTF-8. */
+
+/**
+ * \struct string_builder_allocator_t
+ * \brief Allocator used by a string builder to manage its memory.
+ *
+ * Every function receives the user supplied \p context. Sizes are always
+ * passed back to the allocator so that arena and tracking allocators
+ * do not need to store them. A NULL allocator stands for malloc/realloc/free.
+ */
+typedef struct
+{
+    void *(*alloc_fn)(void *context, size_t size); /**< Allocates \p size bytes, or returns NULL. */
+    void *(*realloc_fn)(void *context, void *ptr, size_t old_size, size_t new_size); /**< Resizes an allocation, or returns NULL. */
+    void (*free_fn)(void *context, void *ptr, size_t size); /**< Releases an allocation of \p size bytes. */
+    void *context; /**< User data passed to every function. */
+} string_builder_allocator_t;
+
+/**
+ * \struct string_builder_sink_t
+ * \brief Destination that a streaming string builder flushes its buffer to.
+ */
+typedef struct
+{
+    int (*write_fn)(void *context, const char *data, size_t len); /**< Consumes \p len characters, returns 0 on success. */
+    void *context; /**< User data passed to \p write_fn. */
+} string_builder_sink_t;
+
+/**
+ * \struct string_builder_utf8_t
+ * \brief Progress of the incremental UTF-8 validation of a string builder.
+ *
+ * The decoder states pack the number of continuation bytes still expected
+ * (bits 0-7) and the range the next one must fall in (bits 8-15 and 16-23).
+ */
+typedef struct
+{
+    size_t offset; /**< Number of characters validated so far, including drained ones. */
+    size_t checked; /**< Number of buffered characters validated so far. */
+    size_t error; /**< Offset of the first invalid byte, or SIZE_MAX if there is none. */
+    uint32_t state; /**< Decoder state after the validated characters. */
+    uint32_t drained_state; /**< Decoder state at the start of the buffer. */
+} string_builder_utf8_t;
 
 /**
  * \struct string_builder_t
@@ -45,222 +146,5586 @@ typedef struct
     char *buf;        /**< Pointer to the character buffer. */
     size_t idx;       /**< Current index (length) of the string. */
     size_t capacity;  /**< Total capacity of the buffer. */
-    double growth_factor; /**< Growth factor for buffer resizing (not used in this implementation). */
+    double growth_factor; /**< Growth factor for buffer resizing. */
+    unsigned int flags; /**< Combination of STRING_BUILDER_FLAG_* values. */
+    const string_builder_allocator_t *allocator; /**< Allocator for the buffer (NULL for libc). */
+    const string_builder_sink_t *sink; /**< Sink that receives the buffer when it fills up (NULL to grow instead). */
+    string_builder_utf8_t utf8; /**< UTF-8 validation progress (only with STRING_BUILDER_FLAG_VALIDATE_UTF8). */
 } string_builder_t;
 
 /**
- * \brief Initializes a string_builder_t with a given capacity.
+ * \struct small_string_builder_t
+ * \brief A string builder that carries its own inline storage.
  *
- * Allocates memory for the buffer and sets the initial index to 0.
- * Exits the program if memory allocation fails.
+ * Short strings are built entirely inside \p storage and never touch the heap.
+ * Once the contents exceed STRING_BUILDER_INLINE_CAPACITY characters, the builder
+ * spills to a heap allocated buffer. Use \p base with every string_builder_t function.
  *
- * \param builder Pointer to the string_builder_t to initialize.
- * \param capacity Initial capacity of the buffer (excluding null terminator).
- * \param growth_factor Growth factor for resizing the buffer.
+ * The inline storage is referenced by pointer, so the structure must not be
+ * copied or moved while the builder still uses it.
  */
-static inline void init_string_builder(string_builder_t *builder, const size_t capacity, const double growth_factor)
+typedef struct
 {
-    builder->capacity = capacity;
+    string_builder_t base; /**< The underlying builder. */
+    char storage[STRING_BUILDER_INLINE_CAPACITY + 1]; /**< Inline storage (+1 for null terminator). */
+} small_string_builder_t;
 
-    // Allocate a new buffer (+1 for null terminator)
-    char *buf = (char *)malloc(sizeof(char) * (capacity + 1));
+/**
+ * \brief Prints an out of memory error and exits the program.
+ *
+ * \param origin Name of the allocation function that failed.
+ */
+static inline void out_of_memory_string_builder(const char *origin)
+{
+#   ifndef _WIN32
+    perror(origin);
+#   else
+    (void)origin;
+    puts("Runtime error: Out of memory");
+#   endif
+    exit(1);
+}
 
-    // Check if we got NULL
-    if (buf == NULL)
+/**
+ * \brief Prints a size overflow error and exits the program.
+ */
+static inline void overflow_string_builder(void)
+{
+    puts("Runtime error: String builder overflow");
+    exit(1);
+}
+
+/**
+ * \brief Adds two sizes, exiting the program if the sum overflows.
+ *
+ * \param a First size.
+ * \param b Second size.
+ * \return The sum of \p a and \p b.
+ */
+static inline size_t add_size_string_builder(const size_t a, const size_t b)
+{
+    if (b > SIZE_MAX - a)
     {
-#       ifndef _WIN32
-            perror("malloc");
-#       else
-            puts("Runtime error: Out of memory");
-#       endif
-        exit(1);
+        overflow_string_builder();
     }
 
-    builder->buf = buf;
-    builder->idx = 0;
-    builder->growth_factor = growth_factor;
+    return a + b;
 }
 
 /**
- * \brief Finalizes the string and returns the internal buffer without copying.
+ * \brief Multiplies two sizes, exiting the program if the product overflows.
  *
- * Appends a null terminator at the current index and returns the buffer.
- * The caller must not free the returned pointer directly.
+ * \param a First size.
+ * \param b Second size.
+ * \return The product of \p a and \p b.
+ */
+static inline size_t mul_size_string_builder(const size_t a, const size_t b)
+{
+    if (a != 0 && b > SIZE_MAX / a)
+    {
+        overflow_string_builder();
+    }
+
+    return a * b;
+}
+
+/**
+ * \brief Checks whether \p n characters cannot fit the buffer of a streaming builder.
+ *
+ * Writers that would otherwise reserve \p n characters at once fall back to
+ * smaller writes in that case, so streaming builders keep their buffer size.
  *
  * \param builder Pointer to the string_builder_t.
- * \return Pointer to the internal buffer (null-terminated string).
+ * \param n Number of characters about to be written.
+ * \return Nonzero if the builder streams to a sink and \p n exceeds its capacity.
  */
-static inline char *collect_string_builder_no_copy(const string_builder_t *builder)
+static inline int exceeds_stream_buffer_string_builder(const string_builder_t *builder, const size_t n)
 {
-    // Add a null terminator
-    builder->buf[builder->idx] = '\0';
-    return builder->buf;
+    return builder->sink != NULL && n > builder->capacity;
 }
 
 /**
- * \brief Finalizes the string and returns a newly allocated copy.
+ * \brief Returns how many input units a kernel processes per block.
  *
- * Appends a null terminator and returns a heap-allocated copy of the string.
- * The caller is responsible for freeing the returned pointer.
+ * Other builders use blocks of STRING_BUILDER_ESCAPE_BLOCK units. Streaming
+ * builders use blocks whose worst-case output fits their buffer.
  *
  * \param builder Pointer to the string_builder_t.
- * \return Newly allocated null-terminated string.
+ * \param expansion Maximum number of characters written per input unit.
+ * \return Number of input units per block (at least 1).
  */
-static inline char *collect_string_builder(const string_builder_t *builder)
+static inline size_t escape_block_string_builder(const string_builder_t *builder, const size_t expansion)
 {
-    // Copy the string
-    char *copy = (char *)malloc(sizeof(char) * (builder->idx + 1)); // +1 for null terminator
-    if (copy == NULL)
+    if (builder->sink == NULL)
     {
-        return NULL; // Return NULL if memory allocation fails
+        return STRING_BUILDER_ESCAPE_BLOCK;
     }
 
-    // Use memcpy to copy the string
-    memcpy(copy, builder->buf, sizeof(char) * builder->idx);
-    copy[builder->idx] = '\0'; // Add null terminator
-
-    return copy;
+    const size_t block = builder->capacity / expansion;
+    return block == 0 ? 1 : block < STRING_BUILDER_ESCAPE_BLOCK ? block : STRING_BUILDER_ESCAPE_BLOCK;
 }
 
 /**
- * \brief Reallocates the buffer of the string_builder_t to accommodate more characters.
+ * \brief Allocates memory through the given allocator.
  *
- * Increases the capacity of the builder by multiplying it with the growth_factor,
- * then reallocates the buffer to the new capacity (+1 for the null terminator).
- * If memory allocation fails, prints an error message and exits the program.
+ * \param allocator Allocator to use, or NULL for malloc.
+ * \param size Number of bytes to allocate.
+ * \return Pointer to the allocated memory, or NULL on failure.
+ */
+static inline void *alloc_mem_string_builder(const string_builder_allocator_t *allocator, const size_t size)
+{
+    if (allocator == NULL)
+    {
+        return malloc(size);
+    }
+
+    return allocator->alloc_fn(allocator->context, size);
+}
+
+/**
+ * \brief Resizes memory through the given allocator.
  *
- * \param builder Pointer to the string_builder_t whose buffer will be reallocated.
+ * \param allocator Allocator to use, or NULL for realloc.
+ * \param ptr Allocation to resize.
+ * \param old_size Current size of the allocation.
+ * \param new_size Requested size of the allocation.
+ * \return Pointer to the resized memory, or NULL on failure.
  */
-static void reallocate_string_builder(string_builder_t *builder)
+static inline void *realloc_mem_string_builder(
+    const string_builder_allocator_t *allocator,
+    void *ptr,
+    const size_t old_size,
+    const size_t new_size
+)
 {
-    // Grow the capacity
-    builder->capacity *= builder->growth_factor;
+    if (allocator == NULL)
+    {
+        return realloc(ptr, new_size);
+    }
 
-    // Reallocate immediately (+1 for null terminator)
-    char *new_buffer = (char *)realloc(builder->buf, sizeof(char) * (builder->capacity + 1));
+    return allocator->realloc_fn(allocator->context, ptr, old_size, new_size);
+}
 
-    // Check if we got NULL
-    if (new_buffer == NULL)
+/**
+ * \brief Releases memory through the given allocator.
+ *
+ * \param allocator Allocator to use, or NULL for free.
+ * \param ptr Allocation to release.
+ * \param size Size of the allocation.
+ */
+static inline void free_mem_string_builder(const string_builder_allocator_t *allocator, void *ptr, const size_t size)
+{
+    if (allocator == NULL)
     {
-#       ifndef _WIN32
-        perror("realloc");
-#       else
-        puts("Runtime error: Out of memory");
-#       endif
-        exit(1);
+        free(ptr);
+        return;
     }
 
-    builder->buf = new_buffer;
+    allocator->free_fn(allocator->context, ptr, size);
 }
 
 /**
- * \brief Appends a single character to the string_builder_t.
+ * \brief Initializes a string_builder_t that allocates through a custom allocator.
  *
- * Automatically reallocates the buffer if needed.
+ * Allocates memory for the buffer and sets the initial index to 0.
+ * The allocator must outlive the builder.
  * Exits the program if memory allocation fails.
  *
- * \param builder Pointer to the string_builder_t.
- * \param c Character to append.
+ * \param builder Pointer to the string_builder_t to initialize.
+ * \param capacity Initial capacity of the buffer (excluding null terminator).
+ * \param growth_factor Growth factor for resizing the buffer.
+ * \param allocator Allocator to use, or NULL for malloc/realloc/free.
  */
-static inline void write_char_string_builder(string_builder_t *builder, const char c)
+static inline void init_string_builder_with_allocator(
+    string_builder_t *builder,
+    const size_t capacity,
+    const double growth_factor,
+    const string_builder_allocator_t *allocator
+)
 {
-    // Check if we have to reallocate the buffer
-    if (builder->idx == builder->capacity)
+    builder->capacity = capacity;
+
+    // Allocate a new buffer (+1 for null terminator)
+    char *buf = (char *)alloc_mem_string_builder(allocator, sizeof(char) * (capacity + 1));
+
+    // Check if we got NULL
+    if (buf == NULL)
     {
-        reallocate_string_builder(builder);
+        out_of_memory_string_builder("malloc");
     }
 
+    builder->buf = buf;
+    builder->idx = 0;
+    builder->growth_factor = growth_factor;
+    builder->flags = 0;
+    builder->allocator = allocator;
+    builder->sink = NULL;
+}
 
-    // Write the character to the buffer
-    builder->buf[builder->idx] = c;
-    builder->idx++;
+/**
+ * \brief Initializes a string_builder_t with a given capacity.
+ *
+ * Allocates memory for the buffer and sets the initial index to 0.
+ * Exits the program if memory allocation fails.
+ *
+ * \param builder Pointer to the string_builder_t to initialize.
+ * \param capacity Initial capacity of the buffer (excluding null terminator).
+ * \param growth_factor Growth factor for resizing the buffer.
+ */
+static inline void init_string_builder(string_builder_t *builder, const size_t capacity, const double growth_factor)
+{
+    init_string_builder_with_allocator(builder, capacity, growth_factor, NULL);
 }
 
 /**
- * \brief Appends up to n characters from a given string to the string_builder_t.
+ * \brief Initializes a string_builder_t on top of a caller provided buffer.
  *
- * Copies at most n characters from the input string \p str into the builder's buffer.
- * Automatically reallocates the buffer as needed to accommodate all characters.
- * Assumes that \p str is at least n bytes long.
+ * The builder writes into \p buffer until it runs out of space, at which point
+ * the contents are moved to a heap allocated buffer. The caller keeps ownership
+ * of \p buffer, which must outlive the builder and be at least
+ * \p capacity + 1 bytes long (for the null terminator).
+ * Heap buffers are obtained from libc unless \p allocator is set afterwards.
  *
- * \param builder Pointer to the string_builder_t.
- * \param str Pointer to the source string (not necessarily null-terminated).
- * \param n Number of characters to append from \p str.
+ * \param builder Pointer to the string_builder_t to initialize.
+ * \param buffer Storage to write into before spilling to the heap.
+ * \param capacity Capacity of \p buffer (excluding null terminator).
+ * \param growth_factor Growth factor for resizing the buffer.
  */
-static inline void write_string_builder_ranged(string_builder_t *builder, const char *str, const size_t n)
+static inline void init_string_builder_with_buffer(
+    string_builder_t *builder,
+    char *buffer,
+    const size_t capacity,
+    const double growth_factor
+)
 {
-    // NOTE: We assume that str is at least n bytes long
-    // Copy all characters
-    size_t remaining_write = n;
-    while (remaining_write > 0)
+    builder->buf = buffer;
+    builder->idx = 0;
+    builder->capacity = capacity;
+    builder->growth_factor = growth_factor;
+    builder->flags = STRING_BUILDER_FLAG_BORROWED;
+    builder->allocator = NULL;
+    builder->sink = NULL;
+}
+
+/**
+ * \brief Initializes a streaming string_builder_t that flushes to a sink.
+ *
+ * The buffer keeps a fixed capacity: whenever a write would overflow it, the
+ * buffered characters are handed to \p sink and the buffer is reused, so memory
+ * stays constant no matter how much is written. The write functions of this
+ * header split their output or pass it straight to the sink rather than reserve
+ * more than the buffer holds; only explicit reservations (reserve_string_builder
+ * and friends, or ensure_string_builder from outside code) can still grow it.
+ * Call flush_sink_string_builder once done to hand over the remaining characters.
+ * The sink must outlive the builder.
+ * Exits the program if memory allocation fails.
+ *
+ * \param builder Pointer to the string_builder_t to initialize.
+ * \param capacity Capacity of the buffer (excluding null terminator), raised to
+ *        STRING_BUILDER_SINK_MIN_CAPACITY if smaller.
+ * \param sink Sink that receives the output.
+ */
+static inline void init_string_builder_with_sink(
+    string_builder_t *builder,
+    const size_t capacity,
+    const string_builder_sink_t *sink
+)
+{
+    // Oversized reservations grow the buffer exactly
+    init_string_builder(builder, capacity < STRING_BUILDER_SINK_MIN_CAPACITY ? STRING_BUILDER_SINK_MIN_CAPACITY : capacity, 1.0);
+    builder->sink = sink;
+}
+
+/**
+ * \brief Validates characters as the continuation of the UTF-8 text seen so far.
+ *
+ * Sequences may be split across calls. ASCII runs are skipped 32 or 16 bytes
+ * at a time with AVX2 or SSE2 when available; other bytes go through a scalar
+ * decoder that checks the ranges of Unicode table 3-7. Once an error has been
+ * recorded, further characters are only counted.
+ *
+ * \param utf8 Validation progress to advance.
+ * \param data Characters to validate.
+ * \param len Number of characters in \p data.
+ */
+static inline void advance_utf8_string_builder(string_builder_utf8_t *utf8, const char *data, const size_t len)
+{
+    const unsigned char *src = (const unsigned char *)data;
+    uint32_t pending = utf8->state & 0xFF;
+    uint32_t low = (utf8->state >> 8) & 0xFF;
+    uint32_t high = utf8->state >> 16;
+    size_t i = 0;
+
+    // Only the first error is recorded
+    if (utf8->error != SIZE_MAX)
     {
-        // Check how many bytes we can write
-        const size_t space_left = builder->capacity - builder->idx;
-        if (space_left == 0)
+        utf8->offset += len;
+        return;
+    }
+
+    while (i < len)
+    {
+        const unsigned char c = src[i];
+        if (pending > 0)
         {
-            reallocate_string_builder(builder);
+            if (c < low || c > high)
+            {
+                break;
+            }
+
+            pending--;
+            low = 0x80;
+            high = 0xBF;
+            i++;
+            continue;
         }
 
-        // Check if we can write all remaining characters
-        if (space_left >= remaining_write)
+        if (c < 0x80)
         {
-            // Copy the remaining characters
-            memcpy(builder->buf + builder->idx, str, remaining_write);
+            // Skip the ASCII run
+            i++;
+#   ifdef STRING_BUILDER_AVX2
+            while (i + 32 <= len && _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)(src + i))) == 0)
+            {
+                i += 32;
+            }
+#   endif
+#   ifdef STRING_BUILDER_SSE2
+            while (i + 16 <= len && _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(src + i))) == 0)
+            {
+                i += 16;
+            }
+#   endif
+            continue;
+        }
 
-            // Move the index forward
-            builder->idx += remaining_write;
+        // Decode the lead byte
+        if (c < 0xC2 || c > 0xF4)
+        {
             break;
         }
 
-        // Copy only what fits
-        memcpy(builder->buf + builder->idx, str, space_left);
-        builder->idx += space_left; // Update the index
-        str += space_left; // Move the pointer forward
-        remaining_write -= space_left; // Decrease the remaining characters to write
+        pending = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+        low = c == 0xE0 ? 0xA0 : c == 0xF0 ? 0x90 : 0x80;
+        high = c == 0xED ? 0x9F : c == 0xF4 ? 0x8F : 0xBF;
+        i++;
+    }
+
+    if (i < len)
+    {
+        utf8->error = utf8->offset + i;
+        pending = 0;
     }
+
+    utf8->offset += len;
+    utf8->state = pending | low << 8 | high << 16;
 }
 
 /**
- * \brief Appends a null-terminated string to the string_builder_t.
+ * \brief Validates the buffered characters that have not been validated yet.
  *
- * Iterates over the input string and appends each character.
+ * \param builder Pointer to a string_builder_t with STRING_BUILDER_FLAG_VALIDATE_UTF8 set.
+ */
+static inline void sync_utf8_string_builder(string_builder_t *builder)
+{
+    if (builder->utf8.checked < builder->idx)
+    {
+        advance_utf8_string_builder(&builder->utf8, builder->buf + builder->utf8.checked, builder->idx - builder->utf8.checked);
+        builder->utf8.checked = builder->idx;
+    }
+}
+
+/**
+ * \brief Hands the buffered characters of a streaming builder to its sink.
+ *
+ * Empties the buffer afterwards. If the sink fails, the builder is marked
+ * with STRING_BUILDER_FLAG_SINK_ERROR and further output is discarded.
  *
  * \param builder Pointer to the string_builder_t.
- * \param str Null-terminated string to append.
  */
-static inline void write_string_builder(string_builder_t *builder, const char *str)
+static inline void drain_string_builder(string_builder_t *builder)
 {
-    write_string_builder_ranged(builder, str, strlen(str));
+    // Validate the characters before they leave the buffer
+    if (builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8)
+    {
+        sync_utf8_string_builder(builder);
+        builder->utf8.checked = 0;
+        builder->utf8.drained_state = builder->utf8.state;
+    }
+
+    // Pass the buffer unless the sink already failed
+    if (builder->idx > 0 && !(builder->flags & STRING_BUILDER_FLAG_SINK_ERROR))
+    {
+        if (builder->sink->write_fn(builder->sink->context, builder->buf, builder->idx) != 0)
+        {
+            builder->flags |= STRING_BUILDER_FLAG_SINK_ERROR;
+        }
+    }
+
+    builder->idx = 0;
 }
 
 /**
- * \brief Frees the memory used by the string_builder_t's buffer.
+ * \brief Initializes a small_string_builder_t using its inline storage.
  *
- * After calling this function, the buffer pointer is set to NULL.
+ * No memory is allocated until the contents exceed STRING_BUILDER_INLINE_CAPACITY.
  *
- * \param builder Pointer to the string_builder_t to destroy.
+ * \param builder Pointer to the small_string_builder_t to initialize.
+ * \param growth_factor Growth factor used once the builder spills to the heap.
  */
-static inline void destroy_string_builder(string_builder_t *builder)
+static inline void init_small_string_builder(small_string_builder_t *builder, const double growth_factor)
 {
-    // Make sure the buffer is not NULL
-    if (builder->buf == NULL) return;
+    init_string_builder_with_buffer(&builder->base, builder->storage, STRING_BUILDER_INLINE_CAPACITY, growth_factor);
+}
 
-    // Free the buffer and set it to NULL
-    free(builder->buf);
-    builder->buf = NULL;
+/**
+ * \brief Finalizes the string and returns the internal buffer without copying.
+ *
+ * Appends a null terminator at the current index and returns the buffer.
+ * The caller must not free the returned pointer directly.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \return Pointer to the internal buffer (null-terminated string).
+ */
+static inline char *collect_string_builder_no_copy(const string_builder_t *builder)
+{
+    // Add a null terminator
+    builder->buf[builder->idx] = '\0';
+    return builder->buf;
 }
 
 /**
- * \brief Resets the string builder to an empty state.
+ * \brief Finalizes the string and returns a newly allocated copy.
  *
- * Sets the index to 0, effectively clearing the string,
- * but does not deallocate or modify the buffer.
+ * Appends a null terminator and returns a copy of the string obtained from the
+ * builder's allocator. The caller is responsible for freeing the returned pointer
+ * (with free() for the default allocator, or the same allocator with a size of idx + 1).
  *
- * \param builder Pointer to the string_builder_t to reset.
+ * \param builder Pointer to the string_builder_t.
+ * \return Newly allocated null-terminated string.
  */
-static inline void reset_string_builder(string_builder_t *builder)
+static inline char *collect_string_builder(const string_builder_t *builder)
 {
-    builder->idx = 0; // Reset the index to 0
+    // Copy the string
+    char *copy = (char *)alloc_mem_string_builder(builder->allocator, sizeof(char) * (builder->idx + 1)); // +1 for null terminator
+    if (copy == NULL)
+    {
+        return NULL; // Return NULL if memory allocation fails
+    }
+
+    // Use memcpy to copy the string
+    memcpy(copy, builder->buf, sizeof(char) * builder->idx);
+    copy[builder->idx] = '\0'; // Add null terminator
+
+    return copy;
+}
+
+/**
+ * \brief Resizes the buffer of the string_builder_t to an exact capacity.
+ *
+ * Reallocates the buffer to hold \p capacity characters (+1 for the null terminator)
+ * and updates the capacity of the builder. This is the only routine that touches
+ * the underlying allocation when growing or shrinking.
+ * Borrowed buffers are never resized in place: growing moves the contents
+ * to the heap, and shrinking is a no-op.
+ * If memory allocation fails, prints an error message and exits the program.
+ *
+ * \param builder Pointer to the string_builder_t whose buffer will be resized.
+ * \param capacity New capacity of the buffer (excluding null terminator).
+ */
+static inline void resize_string_builder(string_builder_t *builder, const size_t capacity)
+{
+    // Borrowed buffers have to be moved to the heap instead
+    if (builder->flags & STRING_BUILDER_FLAG_BORROWED)
+    {
+        // Keep the borrowed buffer if it is already big enough
+        if (capacity <= builder->capacity)
+        {
+            return;
+        }
+
+        char *heap_buffer = (char *)alloc_mem_string_builder(builder->allocator, sizeof(char) * (capacity + 1));
+        if (heap_buffer == NULL)
+        {
+            out_of_memory_string_builder("malloc");
+        }
+
+        // Move the contents over
+        memcpy(heap_buffer, builder->buf, sizeof(char) * builder->idx);
+        builder->buf = heap_buffer;
+        builder->capacity = capacity;
+        builder->flags &= ~STRING_BUILDER_FLAG_BORROWED;
+        return;
+    }
+
+    // Reallocate immediately (+1 for null terminator)
+    char *new_buffer = (char *)realloc_mem_string_builder(
+        builder->allocator,
+        builder->buf,
+        sizeof(char) * (builder->capacity + 1),
+        sizeof(char) * (capacity + 1)
+    );
+
+    // Check if we got NULL
+    if (new_buffer == NULL)
+    {
+        out_of_memory_string_builder("realloc");
+    }
+
+    builder->buf = new_buffer;
+    builder->capacity = capacity;
+}
+
+/**
+ * \brief Grows the buffer so that it can hold at least \p required characters.
+ *
+ * Computes the final capacity up front by repeatedly applying the growth_factor
+ * to the current capacity until it covers \p required, then resizes the buffer once.
+ * If the growth_factor cannot make progress (e.g. it is <= 1, the capacity is 0,
+ * or the product truncates back to the current capacity, as 1 * 1.5 does), the
+ * buffer is grown to exactly \p required characters.
+ *
+ * \param builder Pointer to the string_builder_t to grow.
+ * \param required Minimum capacity needed (excluding null terminator).
+ */
+static inline void grow_string_builder(string_builder_t *builder, const size_t required)
+{
+    // Check if we already have enough space
+    if (required <= builder->capacity)
+    {
+        return;
+    }
+
+    // Apply the growth factor until we cover the requirement
+    size_t new_capacity = builder->capacity;
+    while (new_capacity < required)
+    {
+        const double scaled = (double)new_capacity * builder->growth_factor;
+
+        // Bail out if the policy would overflow
+        if (scaled >= (double)SIZE_MAX)
+        {
+            new_capacity = required;
+            break;
+        }
+
+        // Bail out if the policy cannot make progress once truncated
+        const size_t next = (size_t)scaled;
+        if (next <= new_capacity)
+        {
+            new_capacity = required;
+            break;
+        }
+
+        new_capacity = next;
+    }
+
+    resize_string_builder(builder, new_capacity);
+}
+
+/**
+ * \brief Makes room for \p additional more characters once the buffer is full.
+ *
+ * Streaming builders first drain their buffer to the sink, and only grow it
+ * (exactly) if a single reservation is larger than the whole buffer, which the
+ * write functions of this header never request. Other builders grow the buffer
+ * at most once, following the growth policy of the builder.
+ * Exits the program if the requested size overflows or memory allocation fails.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param additional Number of characters that are about to be written.
+ */
+static inline void make_room_string_builder(string_builder_t *builder, const size_t additional)
+{
+    // Streaming builders reuse their buffer
+    if (builder->sink != NULL)
+    {
+        drain_string_builder(builder);
+        if (builder->capacity >= additional)
+        {
+            return;
+        }
+    }
+
+    // Make sure the required size does not overflow
+    if (additional > SIZE_MAX - 1 - builder->idx)
+    {
+        overflow_string_builder();
+    }
+
+    grow_string_builder(builder, builder->idx + additional);
+}
+
+/**
+ * \brief Ensures there is room for \p additional more characters.
+ *
+ * Grows the buffer at most once, following the growth policy of the builder,
+ * or drains it to the sink for streaming builders.
+ * Exits the program if the requested size overflows or memory allocation fails.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param additional Number of characters that are about to be written.
+ */
+static inline void ensure_string_builder(string_builder_t *builder, const size_t additional)
+{
+    // Fast path: enough space left
+    if (builder->capacity - builder->idx >= additional)
+    {
+        return;
+    }
+
+    make_room_string_builder(builder, additional);
+}
+
+/**
+ * \brief Reserves space for at least \p capacity characters in total.
+ *
+ * Resizes the buffer to exactly \p capacity characters if it is currently smaller.
+ * Never shrinks the buffer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param capacity Minimum total capacity (excluding null terminator).
+ */
+static inline void reserve_string_builder(string_builder_t *builder, const size_t capacity)
+{
+    // Only grow, never shrink
+    if (capacity > builder->capacity)
+    {
+        resize_string_builder(builder, capacity);
+    }
+}
+
+/**
+ * \brief Reserves space for \p n more characters past the current index.
+ *
+ * Useful when the size of an upcoming batch of writes is known in advance:
+ * the buffer is resized once to exactly fit it and no intermediate growth happens.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param n Number of characters that will be appended.
+ */
+static inline void reserve_additional_string_builder(string_builder_t *builder, const size_t n)
+{
+    // Make sure the required size does not overflow
+    if (n > SIZE_MAX - 1 - builder->idx)
+    {
+        overflow_string_builder();
+    }
+
+    reserve_string_builder(builder, builder->idx + n);
+}
+
+/**
+ * \brief Shrinks the buffer so that it only holds the current contents.
+ *
+ * Gives back any unused capacity to the allocator. Subsequent writes
+ * grow the buffer again following the growth policy.
+ *
+ * \param builder Pointer to the string_builder_t to shrink.
+ */
+static inline void shrink_string_builder(string_builder_t *builder)
+{
+    // Check if there is anything to give back
+    if (builder->capacity > builder->idx)
+    {
+        resize_string_builder(builder, builder->idx);
+    }
+}
+
+/**
+ * \brief Reallocates the buffer of the string_builder_t to accommodate more characters.
+ *
+ * Increases the capacity of the builder by multiplying it with the growth_factor,
+ * then reallocates the buffer to the new capacity (+1 for the null terminator).
+ * If memory allocation fails, prints an error message and exits the program.
+ *
+ * \param builder Pointer to the string_builder_t whose buffer will be reallocated.
+ */
+static inline void reallocate_string_builder(string_builder_t *builder)
+{
+    grow_string_builder(builder, builder->capacity + 1);
+}
+
+/**
+ * \brief Appends a single character to the string_builder_t.
+ *
+ * Automatically reallocates the buffer if needed.
+ * Exits the program if memory allocation fails.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param c Character to append.
+ */
+static inline void write_char_string_builder(string_builder_t *builder, const char c)
+{
+    // Check if we have to reallocate the buffer
+    if (builder->idx == builder->capacity)
+    {
+        make_room_string_builder(builder, 1);
+    }
+
+    // Write the character to the buffer
+    builder->buf[builder->idx] = c;
+    builder->idx++;
+}
+
+/**
+ * \brief Appends up to n characters from a given string to the string_builder_t.
+ *
+ * Copies at most n characters from the input string \p str into the builder's buffer.
+ * Reserves the whole range up front, so the buffer is grown at most once
+ * and the characters are copied with a single memcpy. Streaming builders pass
+ * ranges larger than their buffer directly to the sink.
+ * Assumes that \p str is at least n bytes long.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the source string (not necessarily null-terminated).
+ * \param n Number of characters to append from \p str.
+ */
+static inline void write_string_builder_ranged(string_builder_t *builder, const char *str, const size_t n)
+{
+    // NOTE: We assume that str is at least n bytes long
+    // Streaming builders pass oversized writes straight to the sink
+    if (exceeds_stream_buffer_string_builder(builder, n))
+    {
+        drain_string_builder(builder);
+        if (builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8)
+        {
+            advance_utf8_string_builder(&builder->utf8, str, n);
+            builder->utf8.drained_state = builder->utf8.state;
+        }
+
+        if (!(builder->flags & STRING_BUILDER_FLAG_SINK_ERROR)
+            && builder->sink->write_fn(builder->sink->context, str, n) != 0)
+        {
+            builder->flags |= STRING_BUILDER_FLAG_SINK_ERROR;
+        }
+
+        return;
+    }
+
+    // Reserve the whole range at once
+    ensure_string_builder(builder, n);
+
+    // Copy all characters
+    memcpy(builder->buf + builder->idx, str, n);
+    builder->idx += n; // Move the index forward
+
+    // Validate everything appended since the last check
+    if (builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8)
+    {
+        sync_utf8_string_builder(builder);
+    }
+}
+
+/**
+ * \brief Appends a null-terminated string to the string_builder_t.
+ *
+ * Iterates over the input string and appends each character.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Null-terminated string to append.
+ */
+static inline void write_string_builder(string_builder_t *builder, const char *str)
+{
+    write_string_builder_ranged(builder, str, strlen(str));
+}
+
+/**
+ * \brief Frees the memory used by the string_builder_t's buffer.
+ *
+ * Borrowed buffers (e.g. the inline storage of a small_string_builder_t) are left alone.
+ * After calling this function, the buffer pointer is set to NULL.
+ *
+ * \param builder Pointer to the string_builder_t to destroy.
+ */
+static inline void destroy_string_builder(string_builder_t *builder)
+{
+    // Make sure the buffer is not NULL
+    if (builder->buf == NULL) return;
+
+    // Free the buffer unless it is borrowed, and set it to NULL
+    if (!(builder->flags & STRING_BUILDER_FLAG_BORROWED))
+    {
+        free_mem_string_builder(builder->allocator, builder->buf, sizeof(char) * (builder->capacity + 1));
+    }
+
+    builder->buf = NULL;
+}
+
+/**
+ * \brief Resets the string builder to an empty state.
+ *
+ * Sets the index to 0, effectively clearing the string,
+ * but does not deallocate or modify the buffer.
+ *
+ * \param builder Pointer to the string_builder_t to reset.
+ */
+static inline void reset_string_builder(string_builder_t *builder)
+{
+    builder->idx = 0; // Reset the index to 0
+
+    // Forget the validation of the discarded characters
+    if (builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8)
+    {
+        builder->utf8.offset -= builder->utf8.checked;
+        builder->utf8.checked = 0;
+        builder->utf8.state = builder->utf8.drained_state;
+        if (builder->utf8.error >= builder->utf8.offset)
+        {
+            builder->utf8.error = SIZE_MAX;
+        }
+    }
+}
+
+/**
+ * \brief Truncates the string to its first \p len characters.
+ *
+ * Does nothing if the string is already shorter. The buffer is left untouched.
+ * If UTF-8 validation is enabled, it is rewound to the start of the sequence
+ * that \p len cuts, so at most a few characters are validated again.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param len New length of the string.
+ */
+static inline void truncate_string_builder(string_builder_t *builder, const size_t len)
+{
+    if (len < builder->idx)
+    {
+        builder->idx = len;
+    }
+
+    if ((builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8) && len < builder->utf8.checked)
+    {
+        // Back up over continuation bytes to the lead byte of the sequence
+        const unsigned char *buf = (const unsigned char *)builder->buf;
+        size_t start = len;
+        while (start > 0 && len - start < 3 && (buf[start - 1] & 0xC0) == 0x80)
+        {
+            start--;
+        }
+
+        // More continuation bytes than a sequence allows are already an error before len
+        int boundary = 1;
+        if (start > 0 && buf[start - 1] >= 0xC0)
+        {
+            start--;
+        }
+        else if (start > 0 && (buf[start - 1] & 0xC0) == 0x80)
+        {
+            boundary = 0;
+        }
+
+        builder->utf8.offset -= builder->utf8.checked - start;
+        builder->utf8.checked = start;
+        builder->utf8.state = start == 0 ? builder->utf8.drained_state : 0;
+
+        // An error at the lead byte depends on the bytes before it, so it stays unless it was cut off
+        if (boundary && (builder->utf8.error > builder->utf8.offset || (builder->utf8.error == builder->utf8.offset && start == len)))
+        {
+            builder->utf8.error = SIZE_MAX;
+        }
+
+        sync_utf8_string_builder(builder);
+    }
+}
+
+/**
+ * \brief Enables incremental UTF-8 validation of a string_builder_t.
+ *
+ * From now on, every write_string_builder_ranged call (and every drain of a
+ * streaming builder) validates the characters appended since the previous
+ * check, including those written by the other write functions. Sequences split
+ * across appends are handled, so utf8_error_string_builder answers without a
+ * second pass over the output. The current contents are validated as well.
+ *
+ * \param builder Pointer to the string_builder_t.
+ */
+static inline void enable_utf8_validation_string_builder(string_builder_t *builder)
+{
+    builder->flags |= STRING_BUILDER_FLAG_VALIDATE_UTF8;
+    builder->utf8.offset = 0;
+    builder->utf8.checked = 0;
+    builder->utf8.error = SIZE_MAX;
+    builder->utf8.state = 0;
+    builder->utf8.drained_state = 0;
+    sync_utf8_string_builder(builder);
+}
+
+/**
+ * \brief Returns the offset of the first invalid UTF-8 byte in the output.
+ *
+ * Validates whatever was appended since the last check first. Offsets count
+ * every character written so far, including those already handed to a sink.
+ * Requires enable_utf8_validation_string_builder.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \return Offset of the first invalid byte, the length of the output if it ends
+ *         inside a sequence, or SIZE_MAX if the output is valid UTF-8.
+ */
+static inline size_t utf8_error_string_builder(string_builder_t *builder)
+{
+    sync_utf8_string_builder(builder);
+    if (builder->utf8.error != SIZE_MAX)
+    {
+        return builder->utf8.error;
+    }
+
+    return (builder->utf8.state & 0xFF) != 0 ? builder->utf8.offset : SIZE_MAX;
+}
+
+/**
+ * \struct string_builder_arena_block_t
+ * \brief A block of memory owned by a string_builder_arena_t.
+ *
+ * The usable bytes follow the header directly in the same allocation.
+ */
+typedef struct string_builder_arena_block_t
+{
+    struct string_builder_arena_block_t *next; /**< Previously filled block. */
+    size_t size; /**< Number of usable bytes in the block. */
+    size_t used; /**< Number of bytes handed out so far. */
+} string_builder_arena_block_t;
+
+/**
+ * \struct string_builder_arena_t
+ * \brief A bump allocator that string builders can allocate from.
+ *
+ * Allocations are carved out of large blocks. A builder whose buffer is the
+ * last allocation of the arena grows in place, and releasing memory is a no-op
+ * until the whole arena is reset. The arena hands its address to \p allocator,
+ * so it must not be moved once builders use it.
+ */
+typedef struct
+{
+    string_builder_arena_block_t *head; /**< Block currently being filled. */
+    size_t block_size; /**< Default size of new blocks. */
+    char *last; /**< Most recent allocation, which can be resized in place. */
+    string_builder_allocator_t allocator; /**< Allocator interface backed by this arena. */
+} string_builder_arena_t;
+
+/**
+ * \brief Rounds a size up to STRING_BUILDER_ARENA_ALIGN.
+ *
+ * \param size Size to round.
+ * \return The smallest multiple of STRING_BUILDER_ARENA_ALIGN not below \p size.
+ */
+static inline size_t align_string_builder_arena(const size_t size)
+{
+    return (size + (STRING_BUILDER_ARENA_ALIGN - 1)) & ~(size_t)(STRING_BUILDER_ARENA_ALIGN - 1);
+}
+
+/**
+ * \brief Returns the usable memory of an arena block.
+ *
+ * The header is padded so that the usable memory is aligned like the block itself.
+ *
+ * \param block Pointer to the block.
+ * \return Pointer to the first usable byte of the block.
+ */
+static inline char *data_string_builder_arena_block(string_builder_arena_block_t *block)
+{
+    return (char *)block + align_string_builder_arena(sizeof(string_builder_arena_block_t));
+}
+
+/**
+ * \brief Pushes a new block that can hold at least \p size bytes onto the arena.
+ *
+ * Exits the program if memory allocation fails.
+ *
+ * \param arena Pointer to the string_builder_arena_t.
+ * \param size Minimum number of usable bytes.
+ * \return Pointer to the new block.
+ */
+static inline string_builder_arena_block_t *push_string_builder_arena_block(string_builder_arena_t *arena, const size_t size)
+{
+    const size_t block_size = size > arena->block_size ? size : arena->block_size;
+
+    // Make sure the header fits
+    const size_t header_size = align_string_builder_arena(sizeof(string_builder_arena_block_t));
+    if (block_size > SIZE_MAX - header_size)
+    {
+        out_of_memory_string_builder("malloc");
+    }
+
+    string_builder_arena_block_t *block = (string_builder_arena_block_t *)malloc(header_size + block_size);
+    if (block == NULL)
+    {
+        out_of_memory_string_builder("malloc");
+    }
+
+    block->next = arena->head;
+    block->size = block_size;
+    block->used = 0;
+    arena->head = block;
+    return block;
+}
+
+/**
+ * \brief Allocates \p size bytes from the arena.
+ *
+ * Allocations are aligned to STRING_BUILDER_ARENA_ALIGN, so the arena can back
+ * structures as well as character buffers.
+ *
+ * \param context Pointer to the string_builder_arena_t.
+ * \param size Number of bytes to allocate.
+ * \return Pointer to the allocated memory.
+ */
+static inline void *alloc_string_builder_arena(void *context, const size_t size)
+{
+    string_builder_arena_t *arena = (string_builder_arena_t *)context;
+    string_builder_arena_block_t *block = arena->head;
+    size_t offset = block == NULL ? 0 : align_string_builder_arena(block->used);
+
+    // Start a new block if the current one is full
+    if (block == NULL || offset > block->size || block->size - offset < size)
+    {
+        block = push_string_builder_arena_block(arena, size);
+        offset = 0;
+    }
+
+    // Bump the aligned pointer
+    char *ptr = data_string_builder_arena_block(block) + offset;
+    block->used = offset + size;
+    arena->last = ptr;
+    return ptr;
+}
+
+/**
+ * \brief Resizes an allocation made from the arena.
+ *
+ * Extends the allocation in place when it is the last one of the current block
+ * and there is enough room left, otherwise copies it to a new allocation.
+ *
+ * \param context Pointer to the string_builder_arena_t.
+ * \param ptr Allocation to resize.
+ * \param old_size Current size of the allocation.
+ * \param new_size Requested size of the allocation.
+ * \return Pointer to the resized memory.
+ */
+static inline void *realloc_string_builder_arena(void *context, void *ptr, const size_t old_size, const size_t new_size)
+{
+    string_builder_arena_t *arena = (string_builder_arena_t *)context;
+    string_builder_arena_block_t *block = arena->head;
+
+    // Try to resize the last allocation in place
+    if (ptr != NULL && (char *)ptr == arena->last)
+    {
+        // The last allocation starts at an aligned offset
+        const size_t offset = (size_t)(arena->last - data_string_builder_arena_block(block));
+        if (block->size - offset >= new_size)
+        {
+            block->used = offset + new_size;
+            return ptr;
+        }
+    }
+    else if (new_size <= old_size)
+    {
+        // Shrinking anything else just keeps the memory
+        return ptr;
+    }
+
+    // Fall back to a fresh allocation
+    void *new_ptr = alloc_string_builder_arena(context, new_size);
+    if (ptr != NULL)
+    {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    }
+
+    return new_ptr;
+}
+
+/**
+ * \brief Releases an allocation made from the arena.
+ *
+ * Only the last allocation is given back to the arena, everything else
+ * is reclaimed when the arena is reset.
+ *
+ * \param context Pointer to the string_builder_arena_t.
+ * \param ptr Allocation to release.
+ * \param size Size of the allocation.
+ */
+static inline void free_string_builder_arena(void *context, void *ptr, const size_t size)
+{
+    string_builder_arena_t *arena = (string_builder_arena_t *)context;
+    (void)size;
+
+    // Roll back the last allocation
+    if (ptr != NULL && (char *)ptr == arena->last)
+    {
+        arena->head->used = (size_t)(arena->last - data_string_builder_arena_block(arena->head));
+        arena->last = NULL;
+    }
+}
+
+/**
+ * \brief Initializes a string_builder_arena_t.
+ *
+ * No memory is allocated until the first builder is created in the arena.
+ *
+ * \param arena Pointer to the string_builder_arena_t to initialize.
+ * \param block_size Default size of the blocks allocated by the arena.
+ */
+static inline void init_string_builder_arena(string_builder_arena_t *arena, const size_t block_size)
+{
+    arena->head = NULL;
+    arena->block_size = block_size;
+    arena->last = NULL;
+    arena->allocator.alloc_fn = alloc_string_builder_arena;
+    arena->allocator.realloc_fn = realloc_string_builder_arena;
+    arena->allocator.free_fn = free_string_builder_arena;
+    arena->allocator.context = arena;
+}
+
+/**
+ * \brief Initializes a string_builder_t that allocates from an arena.
+ *
+ * destroy_string_builder becomes a no-op for this builder; its memory
+ * is reclaimed by reset_string_builder_arena or destroy_string_builder_arena.
+ *
+ * \param builder Pointer to the string_builder_t to initialize.
+ * \param arena Arena to allocate from.
+ * \param capacity Initial capacity of the buffer (excluding null terminator).
+ * \param growth_factor Growth factor for resizing the buffer.
+ */
+static inline void init_string_builder_in_arena(
+    string_builder_t *builder,
+    string_builder_arena_t *arena,
+    const size_t capacity,
+    const double growth_factor
+)
+{
+    init_string_builder_with_allocator(builder, capacity, growth_factor, &arena->allocator);
+}
+
+/**
+ * \brief Releases every allocation of the arena at once.
+ *
+ * Keeps the most recent block around for reuse and frees the others.
+ * Builders created in the arena must not be used afterwards.
+ *
+ * \param arena Pointer to the string_builder_arena_t to reset.
+ */
+static inline void reset_string_builder_arena(string_builder_arena_t *arena)
+{
+    // Make sure we have any block at all
+    if (arena->head == NULL) return;
+
+    // Free every block but the head
+    string_builder_arena_block_t *block = arena->head->next;
+    while (block != NULL)
+    {
+        string_builder_arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->head->next = NULL;
+    arena->head->used = 0;
+    arena->last = NULL;
+}
+
+/**
+ * \brief Frees every block owned by the arena.
+ *
+ * Builders created in the arena must not be used afterwards.
+ *
+ * \param arena Pointer to the string_builder_arena_t to destroy.
+ */
+static inline void destroy_string_builder_arena(string_builder_arena_t *arena)
+{
+    string_builder_arena_block_t *block = arena->head;
+    while (block != NULL)
+    {
+        string_builder_arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->head = NULL;
+    arena->last = NULL;
+}
+
+/**
+ * \struct string_builder_slice_t
+ * \brief A read-only view over a range of characters.
+ */
+typedef struct
+{
+    const char *ptr; /**< Pointer to the first character. */
+    size_t len; /**< Number of characters in the range. */
+} string_builder_slice_t;
+
+/**
+ * \struct string_builder_segment_t
+ * \brief A fixed-size chunk of a segmented_string_builder_t.
+ *
+ * The characters follow the header directly in the same allocation.
+ */
+typedef struct string_builder_segment_t
+{
+    struct string_builder_segment_t *next; /**< Next segment in the chain. */
+    size_t size; /**< Number of characters the segment can hold. */
+    size_t used; /**< Number of characters written to the segment. */
+} string_builder_segment_t;
+
+/**
+ * \struct segmented_string_builder_t
+ * \brief A string builder that stores its contents in a chain of segments.
+ *
+ * Appends fill fixed-size segments and link a new one when the current segment
+ * is full, so the contents are never reallocated or copied while building.
+ * The result can be flattened once at the end or consumed segment by segment.
+ */
+typedef struct
+{
+    string_builder_segment_t *head; /**< First segment of the chain. */
+    string_builder_segment_t *tail; /**< Segment currently being filled. */
+    size_t segment_size; /**< Capacity of every new segment. */
+    size_t len; /**< Total number of characters written. */
+    size_t segment_count; /**< Number of segments in the chain. */
+    const string_builder_allocator_t *allocator; /**< Allocator for the segments (NULL for libc). */
+} segmented_string_builder_t;
+
+/**
+ * \brief Returns the characters of a segment.
+ *
+ * \param segment Pointer to the segment.
+ * \return Pointer to the first character of the segment.
+ */
+static inline char *data_string_builder_segment(string_builder_segment_t *segment)
+{
+    return (char *)(segment + 1);
+}
+
+/**
+ * \brief Initializes a segmented_string_builder_t that allocates through a custom allocator.
+ *
+ * No memory is allocated until the first character is written.
+ *
+ * \param builder Pointer to the segmented_string_builder_t to initialize.
+ * \param segment_size Number of characters every segment can hold.
+ * \param allocator Allocator to use, or NULL for malloc/free.
+ */
+static inline void init_segmented_string_builder_with_allocator(
+    segmented_string_builder_t *builder,
+    const size_t segment_size,
+    const string_builder_allocator_t *allocator
+)
+{
+    builder->head = NULL;
+    builder->tail = NULL;
+    builder->segment_size = segment_size == 0 ? 1 : segment_size;
+    builder->len = 0;
+    builder->segment_count = 0;
+    builder->allocator = allocator;
+}
+
+/**
+ * \brief Initializes a segmented_string_builder_t.
+ *
+ * No memory is allocated until the first character is written.
+ *
+ * \param builder Pointer to the segmented_string_builder_t to initialize.
+ * \param segment_size Number of characters every segment can hold.
+ */
+static inline void init_segmented_string_builder(segmented_string_builder_t *builder, const size_t segment_size)
+{
+    init_segmented_string_builder_with_allocator(builder, segment_size, NULL);
+}
+
+/**
+ * \brief Links a new empty segment at the end of the chain.
+ *
+ * Exits the program if memory allocation fails.
+ *
+ * \param builder Pointer to the segmented_string_builder_t.
+ */
+static inline void push_segmented_string_builder(segmented_string_builder_t *builder)
+{
+    // Make sure the header fits
+    if (builder->segment_size > SIZE_MAX - sizeof(string_builder_segment_t))
+    {
+        out_of_memory_string_builder("malloc");
+    }
+
+    string_builder_segment_t *segment = (string_builder_segment_t *)alloc_mem_string_builder(
+        builder->allocator,
+        sizeof(string_builder_segment_t) + builder->segment_size
+    );
+
+    if (segment == NULL)
+    {
+        out_of_memory_string_builder("malloc");
+    }
+
+    segment->next = NULL;
+    segment->size = builder->segment_size;
+    segment->used = 0;
+
+    // Link the segment
+    if (builder->tail == NULL)
+    {
+        builder->head = segment;
+    }
+    else
+    {
+        builder->tail->next = segment;
+    }
+
+    builder->tail = segment;
+    builder->segment_count++;
+}
+
+/**
+ * \brief Appends n characters from a given string to the segmented_string_builder_t.
+ *
+ * Fills the current segment and links new ones as needed.
+ * Previously written characters are never moved.
+ *
+ * \param builder Pointer to the segmented_string_builder_t.
+ * \param str Pointer to the source string (not necessarily null-terminated).
+ * \param n Number of characters to append from \p str.
+ */
+static inline void write_segmented_string_builder_ranged(segmented_string_builder_t *builder, const char *str, size_t n)
+{
+    builder->len += n;
+
+    while (n > 0)
+    {
+        // Link a new segment if the current one is full
+        if (builder->tail == NULL || builder->tail->used == builder->tail->size)
+        {
+            push_segmented_string_builder(builder);
+        }
+
+        // Copy what fits in the current segment
+        string_builder_segment_t *segment = builder->tail;
+        const size_t space_left = segment->size - segment->used;
+        const size_t chunk = n < space_left ? n : space_left;
+
+        memcpy(data_string_builder_segment(segment) + segment->used, str, chunk);
+        segment->used += chunk;
+        str += chunk;
+        n -= chunk;
+    }
+}
+
+/**
+ * \brief Appends a null-terminated string to the segmented_string_builder_t.
+ *
+ * \param builder Pointer to the segmented_string_builder_t.
+ * \param str Null-terminated string to append.
+ */
+static inline void write_segmented_string_builder(segmented_string_builder_t *builder, const char *str)
+{
+    write_segmented_string_builder_ranged(builder, str, strlen(str));
+}
+
+/**
+ * \brief Appends a single character to the segmented_string_builder_t.
+ *
+ * \param builder Pointer to the segmented_string_builder_t.
+ * \param c Character to append.
+ */
+static inline void write_char_segmented_string_builder(segmented_string_builder_t *builder, const char c)
+{
+    // Link a new segment if the current one is full
+    if (builder->tail == NULL || builder->tail->used == builder->tail->size)
+    {
+        push_segmented_string_builder(builder);
+    }
+
+    data_string_builder_segment(builder->tail)[builder->tail->used++] = c;
+    builder->len++;
+}
+
+/**
+ * \brief Describes every non-empty segment as a slice, in order.
+ *
+ * Fills at most \p max slices and returns the number of slices needed to
+ * describe the whole contents, so passing NULL and 0 queries the count.
+ * The slices stay valid until the builder is reset or destroyed.
+ *
+ * \param builder Pointer to the segmented_string_builder_t.
+ * \param slices Output array of slices (can be NULL if \p max is 0).
+ * \param max Number of entries available in \p slices.
+ * \return Number of slices describing the contents.
+ */
+static inline size_t collect_segmented_string_builder_slices(
+    const segmented_string_builder_t *builder,
+    string_builder_slice_t *slices,
+    const size_t max
+)
+{
+    size_t count = 0;
+    for (string_builder_segment_t *segment = builder->head; segment != NULL; segment = segment->next)
+    {
+        // Skip empty segments
+        if (segment->used == 0) continue;
+
+        if (count < max)
+        {
+            slices[count].ptr = data_string_builder_segment(segment);
+            slices[count].len = segment->used;
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * \brief Appends the whole contents of the segmented builder to a string_builder_t.
+ *
+ * Reserves the total length once and copies every segment back to back.
+ *
+ * \param builder Pointer to the segmented_string_builder_t.
+ * \param out Pointer to the string_builder_t to append to.
+ */
+static inline void flatten_segmented_string_builder(const segmented_string_builder_t *builder, string_builder_t *out)
+{
+    // Streaming builders keep their buffer size
+    if (exceeds_stream_buffer_string_builder(out, builder->len))
+    {
+        for (string_builder_segment_t *segment = builder->head; segment != NULL; segment = segment->next)
+        {
+            write_string_builder_ranged(out, data_string_builder_segment(segment), segment->used);
+        }
+
+        return;
+    }
+
+    ensure_string_builder(out, builder->len);
+
+    for (string_builder_segment_t *segment = builder->head; segment != NULL; segment = segment->next)
+    {
+        memcpy(out->buf + out->idx, data_string_builder_segment(segment), segment->used);
+        out->idx += segment->used;
+    }
+}
+
+/**
+ * \brief Flattens the contents into a newly allocated string.
+ *
+ * The string is obtained from the builder's allocator. The caller is responsible
+ * for freeing the returned pointer (with free() for the default allocator, or the
+ * same allocator with a size of len + 1).
+ *
+ * \param builder Pointer to the segmented_string_builder_t.
+ * \return Newly allocated null-terminated string, or NULL if memory allocation fails.
+ */
+static inline char *collect_segmented_string_builder(const segmented_string_builder_t *builder)
+{
+    char *copy = (char *)alloc_mem_string_builder(builder->allocator, sizeof(char) * (builder->len + 1)); // +1 for null terminator
+    if (copy == NULL)
+    {
+        return NULL; // Return NULL if memory allocation fails
+    }
+
+    // Copy every segment
+    size_t offset = 0;
+    for (string_builder_segment_t *segment = builder->head; segment != NULL; segment = segment->next)
+    {
+        memcpy(copy + offset, data_string_builder_segment(segment), segment->used);
+        offset += segment->used;
+    }
+
+    copy[offset] = '\0'; // Add null terminator
+    return copy;
+}
+
+/**
+ * \brief Resets the segmented builder to an empty state.
+ *
+ * Keeps the first segment for reuse and frees the others.
+ *
+ * \param builder Pointer to the segmented_string_builder_t to reset.
+ */
+static inline void reset_segmented_string_builder(segmented_string_builder_t *builder)
+{
+    // Make sure we have any segment at all
+    if (builder->head == NULL) return;
+
+    // Free every segment but the first one
+    string_builder_segment_t *segment = builder->head->next;
+    while (segment != NULL)
+    {
+        string_builder_segment_t *next = segment->next;
+        free_mem_string_builder(builder->allocator, segment, sizeof(string_builder_segment_t) + segment->size);
+        segment = next;
+    }
+
+    builder->head->next = NULL;
+    builder->head->used = 0;
+    builder->tail = builder->head;
+    builder->len = 0;
+    builder->segment_count = 1;
+}
+
+/**
+ * \brief Frees every segment of the segmented builder.
+ *
+ * \param builder Pointer to the segmented_string_builder_t to destroy.
+ */
+static inline void destroy_segmented_string_builder(segmented_string_builder_t *builder)
+{
+    string_builder_segment_t *segment = builder->head;
+    while (segment != NULL)
+    {
+        string_builder_segment_t *next = segment->next;
+        free_mem_string_builder(builder->allocator, segment, sizeof(string_builder_segment_t) + segment->size);
+        segment = next;
+    }
+
+    builder->head = NULL;
+    builder->tail = NULL;
+    builder->len = 0;
+    builder->segment_count = 0;
+}
+
+/**
+ * \brief Writes a whole range of characters to a file descriptor.
+ *
+ * Retries on partial writes and when interrupted by a signal.
+ *
+ * \param fd File descriptor to write to.
+ * \param data Pointer to the characters to write.
+ * \param len Number of characters to write.
+ * \return 0 on success, -1 on error (errno is set by the failing write).
+ */
+static inline int write_all_string_builder_fd(const int fd, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+#       ifndef _WIN32
+        const ssize_t written = write(fd, data, len);
+#       else
+        const int written = _write(fd, data, len > 0x7FFFFFFF ? 0x7FFFFFFF : (unsigned int)len);
+#       endif
+
+        // Check for errors
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        // Make sure we made progress
+        if (written == 0)
+        {
+            errno = EIO;
+            return -1;
+        }
+
+        data += written;
+        len -= (size_t)written;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Writes the contents of the string_builder_t to a file descriptor.
+ *
+ * Writes straight from the builder's buffer without copying it,
+ * handling partial writes and signal interruptions.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param fd File descriptor to write to.
+ * \param reset Whether to reset the builder after a successful write.
+ * \return 0 on success, -1 on error (errno is set by the failing write).
+ */
+static inline int flush_string_builder_fd(string_builder_t *builder, const int fd, const int reset)
+{
+    // Write the whole buffer
+    if (write_all_string_builder_fd(fd, builder->buf, builder->idx) != 0)
+    {
+        return -1;
+    }
+
+    if (reset)
+    {
+        reset_string_builder(builder);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Writes every segment of the segmented_string_builder_t to a file descriptor.
+ *
+ * Hands the segments to writev in batches of up to STRING_BUILDER_IOV_BATCH,
+ * handling partial writes and signal interruptions. On Windows, the segments
+ * are written one by one.
+ *
+ * \param builder Pointer to the segmented_string_builder_t.
+ * \param fd File descriptor to write to.
+ * \param reset Whether to reset the builder after a successful write.
+ * \return 0 on success, -1 on error (errno is set by the failing write).
+ */
+static inline int flush_segmented_string_builder_fd(segmented_string_builder_t *builder, const int fd, const int reset)
+{
+    string_builder_segment_t *segment = builder->head;
+
+#   ifndef _WIN32
+    struct iovec iov[STRING_BUILDER_IOV_BATCH];
+    while (segment != NULL)
+    {
+        // Gather the next batch of segments
+        int count = 0;
+        while (segment != NULL && count < STRING_BUILDER_IOV_BATCH)
+        {
+            if (segment->used > 0)
+            {
+                iov[count].iov_base = data_string_builder_segment(segment);
+                iov[count].iov_len = segment->used;
+                count++;
+            }
+
+            segment = segment->next;
+        }
+
+        // Write the batch, resuming after partial writes
+        struct iovec *current = iov;
+        while (count > 0)
+        {
+            const ssize_t written = writev(fd, current, count);
+
+            // Check for errors
+            if (written < 0)
+            {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+
+            // Make sure we made progress
+            if (written == 0)
+            {
+                errno = EIO;
+                return -1;
+            }
+
+            // Skip every fully written segment
+            size_t remaining = (size_t)written;
+            while (count > 0 && remaining >= current->iov_len)
+            {
+                remaining -= current->iov_len;
+                current++;
+                count--;
+            }
+
+            // Move into the partially written segment
+            if (count > 0)
+            {
+                current->iov_base = (char *)current->iov_base + remaining;
+                current->iov_len -= remaining;
+            }
+        }
+    }
+#   else
+    for (; segment != NULL; segment = segment->next)
+    {
+        if (write_all_string_builder_fd(fd, data_string_builder_segment(segment), segment->used) != 0)
+        {
+            return -1;
+        }
+    }
+#   endif
+
+    if (reset)
+    {
+        reset_segmented_string_builder(builder);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Hands every buffered character of a streaming builder to its sink.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \return 0 if every write reached the sink, -1 if the sink failed at any point.
+ */
+static inline int flush_sink_string_builder(string_builder_t *builder)
+{
+    drain_string_builder(builder);
+    return builder->flags & STRING_BUILDER_FLAG_SINK_ERROR ? -1 : 0;
+}
+
+/**
+ * \brief Sink function that writes to the file descriptor stored in \p context.
+ *
+ * \param context File descriptor, cast to a pointer.
+ * \param data Pointer to the characters to write.
+ * \param len Number of characters to write.
+ * \return 0 on success, -1 on error.
+ */
+static inline int write_fd_sink_string_builder(void *context, const char *data, const size_t len)
+{
+    return write_all_string_builder_fd((int)(intptr_t)context, data, len);
+}
+
+/**
+ * \brief Sink function that writes to the FILE stream stored in \p context.
+ *
+ * \param context Pointer to the FILE stream.
+ * \param data Pointer to the characters to write.
+ * \param len Number of characters to write.
+ * \return 0 on success, -1 on error.
+ */
+static inline int write_file_sink_string_builder(void *context, const char *data, const size_t len)
+{
+    return fwrite(data, sizeof(char), len, (FILE *)context) == len ? 0 : -1;
+}
+
+/**
+ * \brief Initializes a sink that writes to a file descriptor.
+ *
+ * \param sink Pointer to the string_builder_sink_t to initialize.
+ * \param fd File descriptor to write to.
+ */
+static inline void init_fd_sink_string_builder(string_builder_sink_t *sink, const int fd)
+{
+    sink->write_fn = write_fd_sink_string_builder;
+    sink->context = (void *)(intptr_t)fd;
+}
+
+/**
+ * \brief Initializes a sink that writes to a FILE stream.
+ *
+ * \param sink Pointer to the string_builder_sink_t to initialize.
+ * \param file FILE stream to write to.
+ */
+static inline void init_file_sink_string_builder(string_builder_sink_t *sink, FILE *file)
+{
+    sink->write_fn = write_file_sink_string_builder;
+    sink->context = file;
+}
+
+/**
+ * \brief Two-character decimal representations of 0 through 99.
+ */
+static const char string_builder_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * \brief Lowercase and uppercase hexadecimal digits.
+ */
+static const char string_builder_hex_digits[2][17] = { "0123456789abcdef", "0123456789ABCDEF" };
+
+/**
+ * \brief Counts the decimal digits of an unsigned integer.
+ *
+ * \param value Value to inspect.
+ * \return Number of digits needed to print \p value (at least 1).
+ */
+static inline size_t count_digits_string_builder(uint64_t value)
+{
+    size_t digits = 1;
+    for (;;)
+    {
+        // Check four digits at a time
+        if (value < 10) return digits;
+        if (value < 100) return digits + 1;
+        if (value < 1000) return digits + 2;
+        if (value < 10000) return digits + 3;
+
+        value /= 10000;
+        digits += 4;
+    }
+}
+
+/**
+ * \brief Counts the significant bits of an unsigned integer.
+ *
+ * \param value Value to inspect.
+ * \return Position of the highest set bit plus one (at least 1).
+ */
+static inline size_t count_bits_string_builder(uint64_t value)
+{
+#   if defined(__GNUC__) || defined(__clang__)
+    return value == 0 ? 1 : (size_t)(64 - __builtin_clzll(value));
+#   else
+    size_t bits = 1;
+    while (value >>= 1)
+    {
+        bits++;
+    }
+
+    return bits;
+#   endif
+}
+
+/**
+ * \brief Writes the decimal digits of a value backwards, ending right before \p end.
+ *
+ * Converts two digits per step using string_builder_digit_pairs.
+ *
+ * \param end Pointer past the last digit to write.
+ * \param value Value to convert.
+ */
+static inline void format_u64_string_builder(char *end, uint64_t value)
+{
+    // Emit two digits at a time
+    while (value >= 100)
+    {
+        const size_t pair = (size_t)(value % 100) * 2;
+        value /= 100;
+        *--end = string_builder_digit_pairs[pair + 1];
+        *--end = string_builder_digit_pairs[pair];
+    }
+
+    // Emit the remaining one or two digits
+    if (value >= 10)
+    {
+        const size_t pair = (size_t)value * 2;
+        *--end = string_builder_digit_pairs[pair + 1];
+        *--end = string_builder_digit_pairs[pair];
+    }
+    else
+    {
+        *--end = (char)('0' + value);
+    }
+}
+
+/**
+ * \brief Writes the digits of a value in a power-of-two base backwards, ending right before \p end.
+ *
+ * \param end Pointer past the last digit to write.
+ * \param value Value to convert.
+ * \param digits Number of digits to write (leading zeros included).
+ * \param shift Number of bits per digit (1, 3 or 4).
+ * \param uppercase Whether hexadecimal digits are written in uppercase.
+ */
+static inline void format_pow2_string_builder(
+    char *end,
+    uint64_t value,
+    size_t digits,
+    const unsigned int shift,
+    const int uppercase
+)
+{
+    const char *table = string_builder_hex_digits[uppercase ? 1 : 0];
+    const uint64_t mask = ((uint64_t)1 << shift) - 1;
+
+    while (digits-- > 0)
+    {
+        *--end = table[value & mask];
+        value >>= shift;
+    }
+}
+
+/**
+ * \brief Appends the decimal representation of an unsigned integer, zero-padded to \p width.
+ *
+ * Counts the digits first, reserves once and converts straight into the buffer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ * \param width Minimum number of digits (0 or 1 for no padding).
+ */
+static inline void write_u64_padded_string_builder(string_builder_t *builder, const uint64_t value, const size_t width)
+{
+    const size_t digits = count_digits_string_builder(value);
+    const size_t len = digits < width ? width : digits;
+
+    // Streaming builders write padding wider than their buffer separately
+    if (exceeds_stream_buffer_string_builder(builder, len))
+    {
+        for (size_t i = digits; i < len; i++)
+        {
+            write_char_string_builder(builder, '0');
+        }
+
+        write_u64_padded_string_builder(builder, value, 0);
+        return;
+    }
+
+    ensure_string_builder(builder, len);
+
+    // Pad with zeros and convert
+    char *dest = builder->buf + builder->idx;
+    memset(dest, '0', len - digits);
+    format_u64_string_builder(dest + len, value);
+    builder->idx += len;
+}
+
+/**
+ * \brief Appends the decimal representation of an unsigned 64-bit integer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ */
+static inline void write_u64_string_builder(string_builder_t *builder, const uint64_t value)
+{
+    const size_t digits = count_digits_string_builder(value);
+    ensure_string_builder(builder, digits);
+
+    format_u64_string_builder(builder->buf + builder->idx + digits, value);
+    builder->idx += digits;
+}
+
+/**
+ * \brief Appends the decimal representation of a signed 64-bit integer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ */
+static inline void write_i64_string_builder(string_builder_t *builder, const int64_t value)
+{
+    // Negate in unsigned arithmetic so INT64_MIN is handled
+    const int negative = value < 0;
+    const uint64_t magnitude = negative ? 0 - (uint64_t)value : (uint64_t)value;
+    const size_t len = count_digits_string_builder(magnitude) + (size_t)negative;
+    ensure_string_builder(builder, len);
+
+    char *dest = builder->buf + builder->idx;
+    if (negative)
+    {
+        *dest = '-';
+    }
+
+    format_u64_string_builder(dest + len, magnitude);
+    builder->idx += len;
+}
+
+/**
+ * \brief Appends the decimal representation of an unsigned 32-bit integer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ */
+static inline void write_u32_string_builder(string_builder_t *builder, const uint32_t value)
+{
+    write_u64_string_builder(builder, value);
+}
+
+/**
+ * \brief Appends the decimal representation of a signed 32-bit integer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ */
+static inline void write_i32_string_builder(string_builder_t *builder, const int32_t value)
+{
+    write_i64_string_builder(builder, value);
+}
+
+/**
+ * \brief Appends a value in a power-of-two base, zero-padded to \p width digits.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ * \param width Minimum number of digits (0 or 1 for no padding).
+ * \param shift Number of bits per digit (1, 3 or 4).
+ * \param uppercase Whether hexadecimal digits are written in uppercase.
+ */
+static inline void write_pow2_string_builder(
+    string_builder_t *builder,
+    const uint64_t value,
+    const size_t width,
+    const unsigned int shift,
+    const int uppercase
+)
+{
+    const size_t digits = (count_bits_string_builder(value) + shift - 1) / shift;
+    const size_t len = digits < width ? width : digits;
+
+    // Streaming builders write padding wider than their buffer separately
+    if (exceeds_stream_buffer_string_builder(builder, len))
+    {
+        for (size_t i = digits; i < len; i++)
+        {
+            write_char_string_builder(builder, '0');
+        }
+
+        write_pow2_string_builder(builder, value, 0, shift, uppercase);
+        return;
+    }
+
+    ensure_string_builder(builder, len);
+
+    format_pow2_string_builder(builder->buf + builder->idx + len, value, len, shift, uppercase);
+    builder->idx += len;
+}
+
+/**
+ * \brief Appends the hexadecimal representation of an unsigned integer (no prefix).
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ * \param uppercase Whether to use uppercase digits.
+ */
+static inline void write_hex_u64_string_builder(string_builder_t *builder, const uint64_t value, const int uppercase)
+{
+    write_pow2_string_builder(builder, value, 0, 4, uppercase);
+}
+
+/**
+ * \brief Appends the hexadecimal representation of an unsigned integer, zero-padded to \p width.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ * \param width Minimum number of digits.
+ * \param uppercase Whether to use uppercase digits.
+ */
+static inline void write_hex_u64_padded_string_builder(
+    string_builder_t *builder,
+    const uint64_t value,
+    const size_t width,
+    const int uppercase
+)
+{
+    write_pow2_string_builder(builder, value, width, 4, uppercase);
+}
+
+/**
+ * \brief Appends the octal representation of an unsigned integer (no prefix).
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ */
+static inline void write_oct_u64_string_builder(string_builder_t *builder, const uint64_t value)
+{
+    write_pow2_string_builder(builder, value, 0, 3, 0);
+}
+
+/**
+ * \brief Appends the binary representation of an unsigned integer (no prefix).
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ */
+static inline void write_bin_u64_string_builder(string_builder_t *builder, const uint64_t value)
+{
+    write_pow2_string_builder(builder, value, 0, 1, 0);
+}
+
+/**
+ * \brief Powers of five used by the shortest floating-point conversion (Ryu).
+ *
+ * Entry q holds floor(2^(bitlength(5^q) - 1 + 125) / 5^q) + 1 as a 128-bit value
+ * split into its low and high 64 bits.
+ */
+static const uint64_t string_builder_pow5_inv_split[342][2] = {
+    { 0x1u, 0x2000000000000000u }, { 0x999999999999999Au, 0x1999999999999999u },
+    { 0x47AE147AE147AE15u, 0x147AE147AE147AE1u }, { 0x6C8B4395810624DEu, 0x10624DD2F1A9FBE7u },
+    { 0x7A786C226809D496u, 0x1A36E2EB1C432CA5u }, { 0x61F9F01B866E43ABu, 0x14F8B588E368F084u },
+    { 0xB4C7F34938583622u, 0x10C6F7A0B5ED8D36u }, { 0x87A6520EC08D236Au, 0x1AD7F29ABCAF4857u },
+    { 0x9FB841A566D74F88u, 0x15798EE2308C39DFu }, { 0xE62D01511F12A607u, 0x112E0BE826D694B2u },
+    { 0xD6AE6881CB5109A4u, 0x1B7CDFD9D7BDBAB7u }, { 0xDEF1ED34A2A73AEAu, 0x15FD7FE17964955Fu },
+    { 0x7F27F0F6E885C8BBu, 0x119799812DEA1119u }, { 0x650CB4BE40D60DF8u, 0x1C25C268497681C2u },
+    { 0xEA70909833DE7193u, 0x16849B86A12B9B01u }, { 0x21F3A6E0297EC143u, 0x1203AF9EE756159Bu },
+    { 0x6985D7CD0F313537u, 0x1CD2B297D889BC2Bu }, { 0x2137DFD73F5A90F9u, 0x170EF54646D49689u },
+    { 0xE75FE645CC4873FAu, 0x12725DD1D243ABA0u }, { 0xA5663D3C7A0D865Du, 0x1D83C94FB6D2AC34u },
+    { 0x511E976394D79EB1u, 0x179CA10C9242235Du }, { 0xDA7EDF82DD794BC1u, 0x12E3B40A0E9B4F7Du },
+    { 0x2A6498D1625BAC68u, 0x1E392010175EE596u }, { 0xEEB6E0A781E2F053u, 0x182DB34012B25144u },
+    { 0x58924D52CE4F26A9u, 0x1357C299A88EA76Au }, { 0x27507BB7B07EA441u, 0x1EF2D0F5DA7DD8AAu },
+    { 0x52A6C95FC0655034u, 0x18C240C4AECB13BBu }, { 0xEEBD44C99EAA690u, 0x13CE9A36F23C0FC9u },
+    { 0xB17953ADC3110A80u, 0x1FB0F6BE50601941u }, { 0xC12DDC8B02740867u, 0x195A5EFEA6B34767u },
+    { 0x3424B06F3529A052u, 0x14484BFEEBC29F86u }, { 0x901D59F290EE19DBu, 0x1039D66589687F9Eu },
+    { 0x4CFBC31DB4B0295Fu, 0x19F623D5A8A73297u }, { 0x3D9635B15D59BAB2u, 0x14C4E977BA1F5BACu },
+    { 0x97AB5E277DE16228u, 0x109D8792FB4C4956u }, { 0xF2ABC9D8C9689D0Du, 0x1A95A5B7F87A0EF0u },
+    { 0x5BBCA17A3ABA173Eu, 0x154484932D2E725Au }, { 0xAFCA1AC82EFB45CBu, 0x11039D428A8B8EAEu },
+    { 0xB2DCF7A6B1920945u, 0x1B38FB9DAA78E44Au }, { 0xF57D92EBC141A104u, 0x15C72FB1552D836Eu },
+    { 0xC46475896767B403u, 0x116C262777579C58u }, { 0x6D6D88DBD8A5ECD2u, 0x1BE03D0BF225C6F4u },
+    { 0x8ABE071646EB23DBu, 0x164CFDA3281E38C3u }, { 0x6EFE6C11D255B649u, 0x11D7314F534B609Cu },
+    { 0xB197134FB6EF8A0Eu, 0x1C8B821885456760u }, { 0x27AC0F72F8BFA1A5u, 0x16D601AD376AB91Au },
+    { 0xB95672C260994E1Eu, 0x1244CE242C5560E1u }, { 0xF5571E03CDC21695u, 0x1D3AE36D13BBCE35u },
+    { 0x2AAC18030B01ABABu, 0x17624F8A762FD82Bu }, { 0xBBBCE0026F348956u, 0x12B50C6EC4F31355u },
+    { 0x92C7CCD0B1EDA889u, 0x1DEE7A4AD4B81EEFu }, { 0xDBD30A408E57BA07u, 0x17F1FB6F10934BF2u },
+    { 0x7CA8D50071DFC806u, 0x1327FC58DA0F6FF5u }, { 0xFAA7BB33E9660CD6u, 0x1EA6608E29B24CBBu },
+    { 0x9552FC298784D711u, 0x18851A0B548EA3C9u }, { 0xAAA8C9BAD2D0AC0Eu, 0x139DAE6F76D88307u },
+    { 0xDDDADC5E1E1AACE3u, 0x1F62B0B257C0D1A5u }, { 0x7E48B04B4B488A4Fu, 0x191BC08EAC9A4151u },
+    { 0xCB6D59D5D5D3A1D9u, 0x141633A556E1CDDAu }, { 0x3C577B1177DC817Bu, 0x1011C2EAABE7D7E2u },
+    { 0xC6F25E825960CF2Au, 0x19B604AAACA62636u }, { 0x6BF518684780A5BBu, 0x14919D5556EB51C5u },
+    { 0x232A79ED06008496u, 0x10747DDDDF22A7D1u }, { 0xD1DD8FE1A3340756u, 0x1A53FC9631D10C81u },
+    { 0xA7E4731AE8F66C45u, 0x150FFD44F4A73D34u }, { 0x531D28E253F8569Eu, 0x10D9976A5D52975Du },
+    { 0xEB61DB03B98D5762u, 0x1AF5BF109550F22Eu }, { 0xBC4E48CFC7A445E8u, 0x159165A6DDDA5B58u },
+    { 0x6371D3D96C836B20u, 0x11411E1F17E1E2ADu }, { 0x9F1C8628AD9F11CDu, 0x1B9B6364F3030448u },
+    { 0xE5B06B53BE18DB0Bu, 0x1615E91D8F359D06u }, { 0xEAF3890FCB4715A2u, 0x11AB20E472914A6Bu },
+    { 0x44B8DB4C7871BC37u, 0x1C45016D841BAA46u }, { 0x3C715D6C6C1635Fu, 0x169D9ABE03495505u },
+    { 0x3638DE456BCDE919u, 0x1217AEFE69077737u }, { 0x56C163A2461641C1u, 0x1CF2B1970E725858u },
+    { 0xDF011C81D1AB67CEu, 0x17288E1271F51379u }, { 0x7F3416CE4155ECA5u, 0x1286D80EC190DC61u },
+    { 0x6520247D3556476Eu, 0x1DA48CE468E7C702u }, { 0xEA801D30F7783925u, 0x17B6D71D20B96C01u },
+    { 0xBB99B0F3F92CFA84u, 0x12F8AC174D612334u }, { 0x5F5C4E532847F739u, 0x1E5AACF215683854u },
+    { 0x7F7D0B75B9D32C2Eu, 0x18488A5B44536043u }, { 0x9930D5F7C7DC2358u, 0x136D3B7C36A919CFu },
+    { 0x8EB4898C72F9D226u, 0x1F152BF9F10E8FB2u }, { 0x722A07A38F2E41B8u, 0x18DDBCC7F40BA628u },
+    { 0xC1BB394FA5BE9AFAu, 0x13E497065CD61E86u }, { 0x9C5EC2190930F7F6u, 0x1FD424D6FAF030D7u },
+    { 0x49E56814075A5FF8u, 0x197683DF2F268D79u }, { 0x6E51201005E1E660u, 0x145ECFE5BF520AC7u },
+    { 0xF1DA800CD181851Au, 0x104BD984990E6F05u }, { 0x4FC400148268D4F5u, 0x1A12F5A0F4E3E4D6u },
+    { 0xD96999AA01ED772Bu, 0x14DBF7B3F71CB711u }, { 0xADEE1488018AC5BCu, 0x10AFF95CC5B09274u },
+    { 0x497CEDA668DE092Cu, 0x1AB328946F80EA54u }, { 0x3ACA57B853E4D424u, 0x155C2076BF9A5510u },
+    { 0x623B7960431D7683u, 0x1116805EFFAEAA73u }, { 0x9D2BF566D1C8BD9Eu, 0x1B5733CB32B110B8u },
+    { 0x7DBCC452416D647Fu, 0x15DF5CA28EF40D60u }, { 0xCAFD69DB678AB6CCu, 0x117F7D4ED8C33DE6u },
+    { 0xAB2F0FC572778ADFu, 0x1BFF2EE48E052FD7u }, { 0x88F273045B92D580u, 0x1665BF1D3E6A8CACu },
+    { 0xD3F528D049424466u, 0x11EAFF4A98553D56u }, { 0xB988414D4203A0A3u, 0x1CAB3210F3BB9557u },
+    { 0x6139CDD76802E6E9u, 0x16EF5B40C2FC7779u }, { 0xE761717920025254u, 0x125915CD68C9F92Du },
+    { 0xA568B58E999D5086u, 0x1D5B561574765B7Cu }, { 0x5120913EE14AA6D2u, 0x177C44DDF6C515FDu },
+    { 0xA74D40FF1AA21F0Eu, 0x12C9D0B1923744CAu }, { 0xBAECE64F769CB4Au, 0x1E0FB44F50586E11u },
+    { 0x3C8BD850C5EE3C3Bu, 0x180C903F7379F1A7u }, { 0xCA0979DA37F1C9C9u, 0x133D4032C2C7F485u },
+    { 0xA9A8C2F6BFE942DBu, 0x1EC866B79E0CBA6Fu }, { 0x2153CF2BCCBA9BE3u, 0x18A0522C7E709526u },
+    { 0x1AA9728970954982u, 0x13B374F06526DDB8u }, { 0xF775840F1A88759Du, 0x1F8587E7083E2F8Cu },
+    { 0x5F9136727BA05E17u, 0x19379FEC0698260Au }, { 0x1940F85B9619E4DFu, 0x142C7FF0054684D5u },
+    { 0xE100C6AFAB47EA4Cu, 0x1023998CD1053710u }, { 0xCE67A44C453FDD47u, 0x19D28F47B4D524E7u },
+    { 0xD852E9D69DCCB106u, 0x14A8729FC3DDB71Fu }, { 0x79DBEE454B0A2738u, 0x1086C219697E2C19u },
+    { 0x295FE3A211A9D859u, 0x1A71368F0F30468Fu }, { 0xBAB31C81A7BB137Au, 0x15275ED8D8F36BA5u },
+    { 0x6228E39AEC95A92Fu, 0x10EC4BE0AD8F8951u }, { 0x9D0E38F7E0EF7517u, 0x1B13AC9AAF4C0EE8u },
+    { 0xB0D82D931A592A79u, 0x15A956E225D67253u }, { 0x8D79BE0F4847552Eu, 0x11544581B7DEC1DCu },
+    { 0x158F967EDA0BBB7Cu, 0x1BBA08CF8C979C94u }, { 0x77A611FF14D62F97u, 0x162E6D72D6DFB076u },
+    { 0xF951A7FF43DE8C79u, 0x11BEBDF578B2F391u }, { 0xC21C3FFED2FDAD8Eu, 0x1C6463225AB7EC1Cu },
+    { 0x1B0333242648AD8u, 0x16B6B5B5155FF017u }, { 0x159C28E9B83A246u, 0x122BC490DDE659ACu },
+    { 0xCEF604175F3903A3u, 0x1D12D41AFCA3C2ACu }, { 0x725E69AC4C2D9C83u, 0x17424348CA1C9BBDu },
+    { 0xF5185489D68AE39Cu, 0x129B69070816E2FDu }, { 0xEE8D540FBDAB05C6u, 0x1DC574D80CF16B2Fu },
+    { 0xBED77672FE226B05u, 0x17D12A4670C1228Cu }, { 0xFF12C528CB4EBC04u, 0x130DBB6B8D674ED6u },
+    { 0xCB513B74787DF9A0u, 0x1E7C5F127BD87E24u }, { 0x90DC929F9FE614Du, 0x18637F41FCAD31B7u },
+    { 0xA0D7D42194CB810Au, 0x1382CC34CA2427C5u }, { 0x67BFB9CF5478CE77u, 0x1F37AD21436D0C6Fu },
+    { 0x1FCC94A5DD2D71F9u, 0x18F9574DCF8A7059u }, { 0x7FD6DD517DBDF4C7u, 0x13FAAC3E3FA1F37Au },
+    { 0xFFBE2EE8C92FEE0Bu, 0x1FF779FD329CB8C3u }, { 0x6631BF20A0F324D6u, 0x1992C7FDC216FA36u },
+    { 0xB827CC1A1A5C1D78u, 0x14756CCB01ABFB5Eu }, { 0x935309AE7B7CE460u, 0x105DF0A267BCC918u },
+    { 0x1EEB42B0C594A099u, 0x1A2FE76A3F9474F4u }, { 0xE58902270476E6E1u, 0x14F31F8832DD2A5Cu },
+    { 0xB7A0CE859D2BEBE7u, 0x10C27FA028B0EEB0u }, { 0x59014A6F61DFDFD8u, 0x1AD0CC33744E4AB4u },
+    { 0xE0CDD525E7E64CADu, 0x1573D68F903EA229u }, { 0x4D7177518651D6F1u, 0x11297872D9CBB4EEu },
+    { 0x7BE8BEE8D6E957E8u, 0x1B758D848FAC54B0u }, { 0xFCBA3253DF211320u, 0x15F7A46A0C89DD59u },
+    { 0x63C8284318E74280u, 0x1192E9EE706E4AAEu }, { 0x60D0D3827D86A66u, 0x1C1E43171A4A1117u },
+    { 0x6B3DA42CECAD21EBu, 0x167E9C127B6E7412u }, { 0x88FE1CF0BD574E56u, 0x11FEE341FC585CDBu },
+    { 0x419694B462254A23u, 0x1CCB0536608D615Fu }, { 0x67ABAA29E81DD4E9u, 0x1708D0F84D3DE77Fu },
+    { 0xB95621BB2017DD87u, 0x126D73F9D764B932u }, { 0xC223692B668C95A5u, 0x1D7BECC2F23AC1EAu },
+    { 0xCE82BA891ED6DE1Du, 0x179657025B6234BBu }, { 0xA53562074BDF1818u, 0x12DEAC01E2B4F6FCu },
+    { 0x3B889CD87964F359u, 0x1E3113363787F194u }, { 0xFC6D4A46C783F5E1u, 0x18274291C6065ADCu },
+    { 0x30576E9F06032B1Au, 0x13529BA7D19EAF17u }, { 0x1A257DCB3CD1DE90u, 0x1EEA92A61C311825u },
+    { 0x481DFE3C30A7E540u, 0x18BBA884E35A79B7u }, { 0xD34B31C9C0865100u, 0x13C9539D82AEC7C5u },
+    { 0x5211E942CDA3B4CDu, 0x1FA885C8D117A609u }, { 0x74DB21023E1C90A4u, 0x19539E3A40DFB807u },
+    { 0xF715B401CB4A0D50u, 0x1442E4FB67196005u }, { 0xF8DE299B09080AA7u, 0x103583FC527AB337u },
+    { 0x8E304291A80CDDD7u, 0x19EF3993B72AB859u }, { 0x3E8D020E200A4B13u, 0x14BF6142F8EEF9E1u },
+    { 0x653D9B3E80083C0Fu, 0x10991A9BFA58C7E7u }, { 0x6EC8F864000D2CE4u, 0x1A8E90F9908E0CA5u },
+    { 0x8BD3F9E999A423EAu, 0x153EDA614071A3B7u }, { 0x3CA994BAE1501CBBu, 0x10FF151A99F482F9u },
+    { 0xC775BAC49BB3612Bu, 0x1B31BB5DC320D18Eu }, { 0xD2C4956A16291A89u, 0x15C162B168E70E0Bu },
+    { 0xDBD0778811BA7BA1u, 0x11678227871F3E6Fu }, { 0x2C80BF401C5D929Bu, 0x1BD8D03F3E9863E6u },
+    { 0xBD33CC3349E47549u, 0x16470CFF6546B651u }, { 0xCA8FD68F6E505DD4u, 0x11D270CC51055EA7u },
+    { 0x4419574BE3B3C953u, 0x1C83E7AD4E6EFDD9u }, { 0x347790982F63AA9u, 0x16CFEC8AA52597E1u },
+    { 0xCF6C60D468C4FBBAu, 0x123FF06EEA847980u }, { 0xE57A34870E07F92Au, 0x1D331A4B10D3F59Au },
+    { 0x512E906C0B399422u, 0x175C1508DA432AE2u }, { 0xDA8BA6BCD5C7A9B5u, 0x12B010D3E1CF5581u },
+    { 0x90DF712E22D90F87u, 0x1DE6815302E5559Cu }, { 0xDA4C5A8B4F140C6Cu, 0x17EB9AA8CF1DDE16u },
+    { 0xAEA37BA2A5A9A38Au, 0x1322E220A5B17E78u }, { 0x7DD25F6AA2A905A9u, 0x1E9E369AA2B59727u },
+    { 0x97DB7F888220D154u, 0x187E92154EF7AC1Fu }, { 0x797C6606CE80A777u, 0x139874DDD8C6234Cu },
+    { 0x8F2D700AE4010BF1u, 0x1F5A549627A36BADu }, { 0xC2459A25000D65Au, 0x191510781FB5EFBEu },
+    { 0x701D1481D99A4515u, 0x1410D9F9B2F7F2FEu }, { 0xC017439B147B6A77u, 0x100D7B2E28C65BFEu },
+    { 0xCCF205C4ED9243F2u, 0x19AF2B7D0E0A2CCAu }, { 0xA5B37D0BE0E9CC2u, 0x148C22CA71A1BD6Fu },
+    { 0x848F973CB3EE3CEu, 0x10701BD527B4978Cu }, { 0xDA0E5BEC78649FB0u, 0x1A4CF9550C5425ACu },
+    { 0x7B3EAFF060507FC0u, 0x150A6110D6A9B7BDu }, { 0x95CBBFF380406633u, 0x10D51A73DEEE2C97u },
+    { 0xEFAC665266CD7052u, 0x1AEE90B964B04758u }, { 0x2623850EB8A459DBu, 0x158BA6FAB6F36C47u },
+    { 0x1E82D0D893B6AE49u, 0x113C85955F29236Cu }, { 0xFD9E1AF41F8AB075u, 0x1B9408EEFEA838ACu },
+    { 0x97B1AF29B2D559F7u, 0x16100725988693BDu }, { 0xAC8E25BAF5777B2Cu, 0x11A66C1E139EDC97u },
+    { 0x7A7D092B2258C513u, 0x1C3D79C9B8FE2DBFu }, { 0x61FDA0EF4EAD6A76u, 0x169794A160CB57CCu },
+    { 0xE7FE1A590BBDEEC5u, 0x1212DD4DE7091309u }, { 0xA6635D5B45FCB13Au, 0x1CEAFBAFD80E84DCu },
+    { 0x851C4AAF6B308DC8u, 0x172262F3133ED0B0u }, { 0xD0E36EF2BC26D7D4u, 0x1281E8C275CBDA26u },
+    { 0xB49F17EAC6A48C86u, 0x1D9CA79D894629D7u }, { 0x2A18DFEF0550706Bu, 0x17B08617A104EE46u },
+    { 0x54E0B3259DD9F389u, 0x12F39E794D9D8B6Bu }, { 0x87CDEB6F62F65274u, 0x1E5297287C2F4578u },
+    { 0xD30B22BF825EA85Du, 0x18421286C9BF6AC6u }, { 0xF3C1BCC684BB9E4u, 0x13680ED23AFF889Fu },
+    { 0x18602C7A4079296Du, 0x1F0CE4839198DA98u }, { 0x46B356C833942124u, 0x18D71D360E13E213u },
+    { 0x388F78A029434DB6u, 0x13DF4A91A4DCB4DCu }, { 0x5A7F2766A86BAF8Au, 0x1FCBAA82A1612160u },
+    { 0x153285EBB9EFBFA2u, 0x196FBB9BB44DB44Du }, { 0xAA8ED189618C994Eu, 0x145962E2F6A4903Du },
+    { 0xEED8A7A11AD6E10Cu, 0x1047824F2BB6D9CAu }, { 0x7E27729B5E249B45u, 0x1A0C03B1DF8AF611u },
+    { 0xFE85F549181D4904u, 0x14D6695B193BF80Du }, { 0xCB9E5DD4134AA0D0u, 0x10AB877C142FF9A4u },
+    { 0xDF63C9535211014Du, 0x1AAC0BF9B9E65C3Au }, { 0x191CA10F74DA6771u, 0x15566FFAFB1EB02Fu },
+    { 0xADB080D92A4852C1u, 0x1111F32F2F4BC025u }, { 0x15E7348EAA0D5134u, 0x1B4FEB7EB212CD09u },
+    { 0xAB1F5D3EEE710DC4u, 0x15D98932280F0A6Du }, { 0xBC1917658B8DA49Du, 0x117AD428200C0857u },
+    { 0x2CF4F23C127C3A94u, 0x1BF7B9D9CCE00D59u }, { 0xF0C3F4FCDB969543u, 0x165FC7E170B33DE0u },
+    { 0x5A365D9716121103u, 0x11E6398126F5CB1Au }, { 0x9056FC24F01CE804u, 0x1CA38F350B22DE90u },
+    { 0xD9DF301D8CE3ECD0u, 0x16E93F5DA2824BA6u }, { 0xE17F59B13D8323DAu, 0x125432B14ECEA2EBu },
+    { 0x68CBC2B52F38395Cu, 0x1D53844EE47DD179u }, { 0x53D6355DBF602DE3u, 0x177603725064A794u },
+    { 0xA9782AB165E68B1Cu, 0x12C4CF8EA6B6EC76u }, { 0xF26AAB56FD744FAu, 0x1E07B27DD78B13F1u },
+    { 0x3F52222ABFDF6A62u, 0x18062864AC6F4327u }, { 0x65DB4E88997F884Eu, 0x1338205089F29C1Fu },
+    { 0x6FC54A7428CC0D4Au, 0x1EC033B40FEA9365u }, { 0x596AA1F68709A43Bu, 0x1899C2F673220F84u },
+    { 0xADEEE7F86C07B696u, 0x13AE3591F5B4D936u }, { 0x497E3FF3E00C5756u, 0x1F7D228322BAF524u },
+    { 0xD464FFF64CD6AC45u, 0x1930E868E89590E9u }, { 0x4383FFF83D7889D1u, 0x14272053ED4473EEu },
+    { 0xCF9CCCC69793A174u, 0x101F4D0FF1038FF1u }, { 0x7F6147A425B90252u, 0x19CBAE7FE805B31Cu },
+    { 0xCC4DD2E9B7C7350Fu, 0x14A2F1FFECD15C16u }, { 0x3D0B0F215FD290D9u, 0x10825B3323DAB012u },
+    { 0x61AB4B689950E7C1u, 0x1A6A2B85062AB350u }, { 0x4E22A2BA1440B967u, 0x1521BC6A6B555C40u },
+    { 0xB4EE894DD009453u, 0x10E7C9EEBC4449CDu }, { 0x1217DA87C800ED51u, 0x1B0C764AC6D3A948u },
+    { 0xDB46486CA000BDDAu, 0x15A391D56BDC876Cu }, { 0x490506BD4CCD64AFu, 0x114FA7DDEFE39F8Au },
+    { 0xA8080AC87AE23AB1u, 0x1BB2A62FE638FF43u }, { 0x5339A239FBE82EF4u, 0x162884F31E93FF69u },
+    { 0x75C7B4FB2FECF25Du, 0x11BA03F5B20FFF87u }, { 0x22D92191E647EA2Eu, 0x1C5CD322B67FFF3Fu },
+    { 0xB57A8141850654F2u, 0x16B0A8E891FFFF65u }, { 0xC4620101373843F5u, 0x1226ED86DB3332B7u },
+    { 0x3A366801F1F39FEEu, 0x1D0B15A491EB8459u }, { 0xFB5EB99B27F6198Bu, 0x173C115074BC69E0u },
+    { 0x2F7EFAE2865E7AD6u, 0x129674405D6387E7u }, { 0xE597F7D0D6FD9156u, 0x1DBD86CD6238D971u },
+    { 0x8479930D78CADAABu, 0x17CAD23DE82D7AC1u }, { 0xD06142712D6F1556u, 0x1308A831868AC89Au },
+    { 0x4D686A4EAF182222u, 0x1E74404F3DAADA91u }, { 0xA453883EF279B4E8u, 0x185D003F6488AEDAu },
+    { 0xE9DC6CFF28615D87u, 0x137D99CC506D58AEu }, { 0xA960AE650D6895A4u, 0x1F2F5C7A1A488DE4u },
+    { 0xBAB3BEB73DED4483u, 0x18F2B061AEA07183u }, { 0x2EF6322C318A9D36u, 0x13F559E7BEE6C136u },
+    { 0xE4BD1D13827761F0u, 0x1FEEF63F97D79B89u }, { 0x83CA7DA9352C4E5Au, 0x198BF832DFDFAFA1u },
+    { 0x9CA1FE20F756A515u, 0x146FF9C24CB2F2E7u }, { 0x4A1B31B3F9121DAAu, 0x1059949B708F28B9u },
+    { 0x435EB5ECC1B695DDu, 0x1A28EDC580E50DF5u }, { 0x35E55E57015EDE4Au, 0x14ED8B04671DA4C4u },
+    { 0xC4B77EAC0118B1D5u, 0x10BE08D0527E1D69u }, { 0xA12597799B5AB622u, 0x1AC9A7B3B7302F0Fu },
+    { 0x4DB7AC6149155E81u, 0x156E1FC2F8F358D9u }, { 0xD7C6238107444B9Bu, 0x1124E63593F5E0ADu },
+    { 0x593D059B3ED3AC2Bu, 0x1B6E3D2286563449u }, { 0xE0FD9E15CBDC89BCu, 0x15F1CA820511C36Du },
+    { 0xB3FE18116FE3A163u, 0x118E3B9B37416924u }, { 0x866359B57FD29BD1u, 0x1C16C5C525357507u },
+    { 0xD1E91491330EE30Eu, 0x16789E3750F790D2u }, { 0x74BA76DA8F3F1C0Bu, 0x11FA182C40C60D75u },
+    { 0xEDF72490E531C678u, 0x1CC359E067A348BBu }, { 0x8B2C1D40B75B052Du, 0x1702AE4D1FB5D3C9u },
+    { 0x6F567DCD5F7C0424u, 0x12688B70E62B0FD4u }, { 0x7EF0C94898C66D06u, 0x1D74124E3D11B2EDu },
+    { 0x98C0A106E09EBD9Fu, 0x17900EA4FDA7C257u }, { 0x470080D24D4BCAE6u, 0x12D9A550CAEC9B79u },
+    { 0xD800CE1D487944A2u, 0x1E29088144ADC58Eu }, { 0x1333D8176D2DD082u, 0x1820D39A9D57D13Fu },
+    { 0xA8F646792424A6CEu, 0x134D76154AACA765u }, { 0x74BD3D8EA03AA47Du, 0x1EE25688777AA56Fu },
+    { 0x5D64313EE6955064u, 0x18B51206C5FBB78Cu }, { 0x4AB68DCBEBAAA6B7u, 0x13C40E6BD1962C70u },
+    { 0x1124161312AAA457u, 0x1FA01712E8F0471Au }, { 0xDA8344DC0EEEE9DFu, 0x194CDF4253F36C14u },
+    { 0xE2029D7CD8BF2180u, 0x143D7F6843292343u }, { 0x4E687DFD7A328133u, 0x103132B9CF541C36u },
+    { 0x4A40C9959050CEB8u, 0x19E851294BB9C6BDu }, { 0x833D477A6A70BC6u, 0x14B9DA876FC7D231u },
+    { 0xA02976C61EEC096Bu, 0x1094AED2BFD30E8Du }, { 0x4257A364ACDBDFu, 0x1A877E1DFFB81749u },
+    { 0xCD01DFB5EA23E319u, 0x153931B1996012A0u }, { 0x70CE4C91881CB5AEu, 0x10FA8E27ADE6754Du },
+    { 0x1AE3ADB5A69455E2u, 0x1B2A7D0C4970BBAFu }, { 0x7BE957C4854377E8u, 0x15BB973D078D62F2u },
+    { 0xC987796A0435F987u, 0x1162DF64060AB58Eu }, { 0x75A58F1006BCC271u, 0x1BD1656CD67788E4u },
+    { 0xF7B7A5A66BCA3527u, 0x16411DF0AB92D3E9u }, { 0x5FC61E1EBCA1C41Fu, 0x11CDB18D560F0FEEu },
+    { 0xFFA363646102D365u, 0x1C7C4F4889B1B316u }, { 0x32E91C504D9BDC51u, 0x16C9D906D48E28DFu },
+    { 0x8F20E37371497D0Eu, 0x123B140576D820B2u }, { 0x7E9B0585820F2E7Cu, 0x1D2B533BF159CDEAu },
+    { 0xCBAF379E01A5BECAu, 0x1755DC2FF447D7EEu }, { 0x958F94B348498A1u, 0x12AB168CC36CACBFu }
+};
+
+/**
+ * \brief Powers of five used by the shortest floating-point conversion (Ryu).
+ *
+ * Entry i holds 5^i scaled to exactly 125 bits, split into its low and high 64 bits.
+ */
+static const uint64_t string_builder_pow5_split[326][2] = {
+    { 0x0u, 0x1000000000000000u }, { 0x0u, 0x1400000000000000u },
+    { 0x0u, 0x1900000000000000u }, { 0x0u, 0x1F40000000000000u },
+    { 0x0u, 0x1388000000000000u }, { 0x0u, 0x186A000000000000u },
+    { 0x0u, 0x1E84800000000000u }, { 0x0u, 0x1312D00000000000u },
+    { 0x0u, 0x17D7840000000000u }, { 0x0u, 0x1DCD650000000000u },
+    { 0x0u, 0x12A05F2000000000u }, { 0x0u, 0x174876E800000000u },
+    { 0x0u, 0x1D1A94A200000000u }, { 0x0u, 0x12309CE540000000u },
+    { 0x0u, 0x16BCC41E90000000u }, { 0x0u, 0x1C6BF52634000000u },
+    { 0x0u, 0x11C37937E0800000u }, { 0x0u, 0x16345785D8A00000u },
+    { 0x0u, 0x1BC16D674EC80000u }, { 0x0u, 0x1158E460913D0000u },
+    { 0x0u, 0x15AF1D78B58C4000u }, { 0x0u, 0x1B1AE4D6E2EF5000u },
+    { 0x0u, 0x10F0CF064DD59200u }, { 0x0u, 0x152D02C7E14AF680u },
+    { 0x0u, 0x1A784379D99DB420u }, { 0x0u, 0x108B2A2C28029094u },
+    { 0x0u, 0x14ADF4B7320334B9u }, { 0x4000000000000000u, 0x19D971E4FE8401E7u },
+    { 0x8800000000000000u, 0x1027E72F1F128130u }, { 0xAA00000000000000u, 0x1431E0FAE6D7217Cu },
+    { 0xD480000000000000u, 0x193E5939A08CE9DBu }, { 0xC9A0000000000000u, 0x1F8DEF8808B02452u },
+    { 0xBE04000000000000u, 0x13B8B5B5056E16B3u }, { 0xAD85000000000000u, 0x18A6E32246C99C60u },
+    { 0xD8E6400000000000u, 0x1ED09BEAD87C0378u }, { 0x878FE80000000000u, 0x13426172C74D822Bu },
+    { 0x6973E20000000000u, 0x1812F9CF7920E2B6u }, { 0x3D0DA8000000000u, 0x1E17B84357691B64u },
+    { 0x8262889000000000u, 0x12CED32A16A1B11Eu }, { 0x22FB2AB400000000u, 0x178287F49C4A1D66u },
+    { 0xABB9F56100000000u, 0x1D6329F1C35CA4BFu }, { 0xCB54395CA0000000u, 0x125DFA371A19E6F7u },
+    { 0xBE2947B3C8000000u, 0x16F578C4E0A060B5u }, { 0x2DB399A0BA000000u, 0x1CB2D6F618C878E3u },
+    { 0xFC90400474400000u, 0x11EFC659CF7D4B8Du }, { 0x7BB4500591500000u, 0x166BB7F0435C9E71u },
+    { 0xDAA16406F5A40000u, 0x1C06A5EC5433C60Du }, { 0xA8A4DE8459868000u, 0x118427B3B4A05BC8u },
+    { 0xD2CE16256FE82000u, 0x15E531A0A1C872BAu }, { 0x87819BAECBE22800u, 0x1B5E7E08CA3A8F69u },
+    { 0xF4B1014D3F6D5900u, 0x111B0EC57E6499A1u }, { 0x71DD41A08F48AF40u, 0x1561D276DDFDC00Au },
+    { 0xE549208B31ADB10u, 0x1ABA4714957D300Du }, { 0x28F4DB456FF0C8EAu, 0x10B46C6CDD6E3E08u },
+    { 0x33321216CBECFB24u, 0x14E1878814C9CD8Au }, { 0xBFFE969C7EE839EDu, 0x1A19E96A19FC40ECu },
+    { 0xF7FF1E21CF512434u, 0x105031E2503DA893u }, { 0xF5FEE5AA43256D41u, 0x14643E5AE44D12B8u },
+    { 0x337E9F14D3EEC892u, 0x197D4DF19D605767u }, { 0x5E46DA08EA7AB6u, 0x1FDCA16E04B86D41u },
+    { 0xA03AEC4845928CB2u, 0x13E9E4E4C2F34448u }, { 0xC849A75A56F72FDEu, 0x18E45E1DF3B0155Au },
+    { 0x7A5C1130ECB4FBD6u, 0x1F1D75A5709C1AB1u }, { 0xEC798ABE93F11D65u, 0x13726987666190AEu },
+    { 0xA797ED6E38ED64BFu, 0x184F03E93FF9F4DAu }, { 0x517DE8C9C728BDEFu, 0x1E62C4E38FF87211u },
+    { 0xD2EEB17E1C7976B5u, 0x12FDBB0E39FB474Au }, { 0x87AA5DDDA397D462u, 0x17BD29D1C87A191Du },
+    { 0xE994F5550C7DC97Bu, 0x1DAC74463A989F64u }, { 0x11FD195527CE9DEDu, 0x128BC8ABE49F639Fu },
+    { 0xD67C5FAA71C24568u, 0x172EBAD6DDC73C86u }, { 0x8C1B77950E32D6C2u, 0x1CFA698C95390BA8u },
+    { 0x57912ABD28DFC639u, 0x121C81F7DD43A749u }, { 0xAD75756C7317B7C8u, 0x16A3A275D494911Bu },
+    { 0x98D2D2C78FDDA5BAu, 0x1C4C8B1349B9B562u }, { 0x9F83C3BCB9EA8794u, 0x11AFD6EC0E14115Du },
+    { 0x764B4ABE8652979u, 0x161BCCA7119915B5u }, { 0x493DE1D6E27E73D7u, 0x1BA2BFD0D5FF5B22u },
+    { 0x6DC6AD264D8F0866u, 0x1145B7E285BF98F5u }, { 0xC938586FE0F2CA80u, 0x159725DB272F7F32u },
+    { 0x7B866E8BD92F7D20u, 0x1AFCEF51F0FB5EFFu }, { 0xAD34051767BDAE34u, 0x10DE1593369D1B5Fu },
+    { 0x9881065D41AD19C1u, 0x15159AF804446237u }, { 0x7EA147F492186032u, 0x1A5B01B605557AC5u },
+    { 0x6F24CCF8DB4F3C1Fu, 0x1078E111C3556CBBu }, { 0x4AEE003712230B27u, 0x14971956342AC7EAu },
+    { 0xDDA98044D6ABCDF0u, 0x19BCDFABC13579E4u }, { 0xA89F02B062B60B6u, 0x10160BCB58C16C2Fu },
+    { 0xCD2C6C35C7B638E4u, 0x141B8EBE2EF1C73Au }, { 0x8077874339A3C71Du, 0x1922726DBAAE3909u },
+    { 0xE0956914080CB8E4u, 0x1F6B0F092959C74Bu }, { 0x6C5D61AC8507F38Eu, 0x13A2E965B9D81C8Fu },
+    { 0x4774BA17A649F072u, 0x188BA3BF284E23B3u }, { 0x1951E89D8FDC6C8Fu, 0x1EAE8CAEF261ACA0u },
+    { 0xFD3316279E9C3D9u, 0x132D17ED577D0BE4u }, { 0x13C7FDBB186434CFu, 0x17F85DE8AD5C4EDDu },
+    { 0x58B9FD29DE7D4203u, 0x1DF67562D8B36294u }, { 0xB7743E3A2B0E4942u, 0x12BA095DC7701D9Cu },
+    { 0xE5514DC8B5D1DB92u, 0x17688BB5394C2503u }, { 0xDEA5A13AE3465277u, 0x1D42AEA2879F2E44u },
+    { 0xB2784C4CE0BF38Au, 0x1249AD2594C37CEBu }, { 0xCDF165F6018EF06Du, 0x16DC186EF9F45C25u },
+    { 0x416DBF7381F2AC88u, 0x1C931E8AB871732Fu }, { 0x88E497A83137ABD5u, 0x11DBF316B346E7FDu },
+    { 0xEB1DBD923D8596CAu, 0x1652EFDC6018A1FCu }, { 0x25E52CF6CCE6FC7Du, 0x1BE7ABD3781ECA7Cu },
+    { 0x97AF3C1A40105DCEu, 0x1170CB642B133E8Du }, { 0xFD9B0B20D0147542u, 0x15CCFE3D35D80E30u },
+    { 0x3D01CDE904199292u, 0x1B403DCC834E11BDu }, { 0x462120B1A28FFB9Bu, 0x1108269FD210CB16u },
+    { 0xD7A968DE0B33FA82u, 0x154A3047C694FDDBu }, { 0xCD93C3158E00F923u, 0x1A9CBC59B83A3D52u },
+    { 0xC07C59ED78C09BB6u, 0x10A1F5B813246653u }, { 0xB09B7068D6F0C2A3u, 0x14CA732617ED7FE8u },
+    { 0xDCC24C830CACF34Cu, 0x19FD0FEF9DE8DFE2u }, { 0xC9F96FD1E7EC180Fu, 0x103E29F5C2B18BEDu },
+    { 0x3C77CBC661E71E13u, 0x144DB473335DEEE9u }, { 0x8B95BEB7FA60E598u, 0x1961219000356AA3u },
+    { 0x6E7B2E65F8F91EFEu, 0x1FB969F40042C54Cu }, { 0xC50CFCFFBB9BB35Fu, 0x13D3E2388029BB4Fu },
+    { 0xB6503C3FAA82A037u, 0x18C8DAC6A0342A23u }, { 0xA3E44B4F95234844u, 0x1EFB1178484134ACu },
+    { 0xE66EAF11BD360D2Bu, 0x135CEAEB2D28C0EBu }, { 0xE00A5AD62C839075u, 0x183425A5F872F126u },
+    { 0x980CF18BB7A47493u, 0x1E412F0F768FAD70u }, { 0x5F0816F752C6C8DCu, 0x12E8BD69AA19CC66u },
+    { 0xF6CA1CB527787B13u, 0x17A2ECC414A03F7Fu }, { 0xF47CA3E2715699D7u, 0x1D8BA7F519C84F5Fu },
+    { 0xF8CDE66D86D62026u, 0x127748F9301D319Bu }, { 0xF7016008E88BA830u, 0x17151B377C247E02u },
+    { 0xB4C1B80B22AE923Cu, 0x1CDA62055B2D9D83u }, { 0x50F91306F5AD1B65u, 0x12087D4358FC8272u },
+    { 0xE53757C8B318623Fu, 0x168A9C942F3BA30Eu }, { 0x9E852DBADFDE7ACFu, 0x1C2D43B93B0A8BD2u },
+    { 0xA3133C94CBEB0CC1u, 0x119C4A53C4E69763u }, { 0x8BD80BB9FEE5CFF1u, 0x16035CE8B6203D3Cu },
+    { 0xAECE0EA87E9F43EEu, 0x1B843422E3A84C8Bu }, { 0x4D40C9294F238A75u, 0x1132A095CE492FD7u },
+    { 0x2090FB73A2EC6D12u, 0x157F48BB41DB7BCDu }, { 0x68B53A508BA78856u, 0x1ADF1AEA12525AC0u },
+    { 0x417144725748B536u, 0x10CB70D24B7378B8u }, { 0x51CD958EED1AE283u, 0x14FE4D06DE5056E6u },
+    { 0xE640FAF2A8619B24u, 0x1A3DE04895E46C9Fu }, { 0xEFE89CD7A93D00F7u, 0x1066AC2D5DAEC3E3u },
+    { 0xEBE2C40D938C4134u, 0x14805738B51A74DCu }, { 0x26DB7510F86F5181u, 0x19A06D06E2611214u },
+    { 0x9849292A9B4592F1u, 0x100444244D7CAB4Cu }, { 0xBE5B73754216F7ADu, 0x1405552D60DBD61Fu },
+    { 0xADF25052929CB598u, 0x1906AA78B912CBA7u }, { 0x996EE4673743E2FFu, 0x1F485516E7577E91u },
+    { 0xFFE54EC0828A6DDFu, 0x138D352E5096AF1Au }, { 0xBFDEA270A32D0957u, 0x18708279E4BC5AE1u },
+    { 0x2FD64B0CCBF84BADu, 0x1E8CA3185DEB719Au }, { 0x5DE5EEE7FF7B2F4Cu, 0x1317E5EF3AB32700u },
+    { 0x755F6AA1FF59FB1Fu, 0x17DDDF6B095FF0C0u }, { 0x92B7454A7F3079E7u, 0x1DD55745CBB7ECF0u },
+    { 0x5BB28B4E8F7E4C30u, 0x12A5568B9F52F416u }, { 0xF29F2E22335DDF3Cu, 0x174EAC2E8727B11Bu },
+    { 0xEF46F9AAC035570Bu, 0x1D22573A28F19D62u }, { 0xD58C5C0AB8215667u, 0x123576845997025Du },
+    { 0x4AEF730D6629AC01u, 0x16C2D4256FFCC2F5u }, { 0x9DAB4FD0BFB41701u, 0x1C73892ECBFBF3B2u },
+    { 0xA28B11E277D08E60u, 0x11C835BD3F7D784Fu }, { 0x8B2DD65B15C4B1F9u, 0x163A432C8F5CD663u },
+    { 0x6DF94BF1DB35DE77u, 0x1BC8D3F7B3340BFCu }, { 0xC4BBCF772901AB0Au, 0x115D847AD000877Du },
+    { 0x35EAC354F34215CDu, 0x15B4E5998400A95Du }, { 0x8365742A30129B40u, 0x1B221EFFE500D3B4u },
+    { 0xD21F689A5E0BA108u, 0x10F5535FEF208450u }, { 0x6A742C0F58E894Au, 0x1532A837EAE8A565u },
+    { 0x4851137132F22B9Du, 0x1A7F5245E5A2CEBEu }, { 0xED32AC26BFD75B42u, 0x108F936BAF85C136u },
+    { 0xA87F57306FCD3212u, 0x14B378469B673184u }, { 0xD29F2CFC8BC07E97u, 0x19E056584240FDE5u },
+    { 0xA3A37C1DD7584F1Eu, 0x102C35F729689EAFu }, { 0x8C8C5B254D2E62E6u, 0x14374374F3C2C65Bu },
+    { 0x6FAF71EEA079FB9Fu, 0x1945145230B377F2u }, { 0xB9B4E6A48987A87u, 0x1F965966BCE055EFu },
+    { 0x674111026D5F4C94u, 0x13BDF7E0360C35B5u }, { 0xC111554308B71FBAu, 0x18AD75D8438F4322u },
+    { 0x7155AA93CAE4E7A8u, 0x1ED8D34E547313EBu }, { 0x26D58A9C5ECF10C9u, 0x13478410F4C7EC73u },
+    { 0xF08AED437682D4FBu, 0x1819651531F9E78Fu }, { 0xECADA89454238A3Au, 0x1E1FBE5A7E786173u },
+    { 0x73EC895CB4963664u, 0x12D3D6F88F0B3CE8u }, { 0x90E7ABB3E1BBC3FDu, 0x1788CCB6B2CE0C22u },
+    { 0x352196A0DA2AB4FDu, 0x1D6AFFE45F818F2Bu }, { 0x134FE24885AB11Eu, 0x1262DFEEBBB0F97Bu },
+    { 0xC1823DADAA715D65u, 0x16FB97EA6A9D37D9u }, { 0x31E2CD19150DB4BFu, 0x1CBA7DE5054485D0u },
+    { 0x1F2DC02FAD2890F7u, 0x11F48EAF234AD3A2u }, { 0xA6F9303B9872B535u, 0x1671B25AEC1D888Au },
+    { 0x50B77C4A7E8F6282u, 0x1C0E1EF1A724EAADu }, { 0x5272ADAE8F199D91u, 0x1188D357087712ACu },
+    { 0x670F591A32E004F6u, 0x15EB082CCA94D757u }, { 0x40D32F60BF980633u, 0x1B65CA37FD3A0D2Du },
+    { 0x4883FD9C77BF03E0u, 0x111F9E62FE44483Cu }, { 0x5AA4FD0395AEC4D8u, 0x156785FBBDD55A4Bu },
+    { 0x314E3C447B1A760Eu, 0x1AC1677AAD4AB0DEu }, { 0xDED0E5AACCF089C9u, 0x10B8E0ACAC4EAE8Au },
+    { 0x96851F15802CAC3Bu, 0x14E718D7D7625A2Du }, { 0xFC2666DAE037D74Au, 0x1A20DF0DCD3AF0B8u },
+    { 0x9D980048CC22E68Eu, 0x10548B68A044D673u }, { 0x84FE005AFF2BA032u, 0x1469AE42C8560C10u },
+    { 0xA63D8071BEF6883Eu, 0x198419D37A6B8F14u }, { 0xCFCCE08E2EB42A4Eu, 0x1FE52048590672D9u },
+    { 0x21E00C58DD309A70u, 0x13EF342D37A407C8u }, { 0x2A580F6F147CC10Du, 0x18EB0138858D09BAu },
+    { 0xB4EE134AD99BF150u, 0x1F25C186A6F04C28u }, { 0x7114CC0EC80176D2u, 0x137798F428562F99u },
+    { 0xCD59FF127A01D486u, 0x18557F31326BBB7Fu }, { 0xC0B07ED7188249A8u, 0x1E6ADEFD7F06AA5Fu },
+    { 0xD86E4F466F516E09u, 0x1302CB5E6F642A7Bu }, { 0xCE89E3180B25C98Bu, 0x17C37E360B3D351Au },
+    { 0x822C5BDE0DEF3BEEu, 0x1DB45DC38E0C8261u }, { 0xF15BB96AC8B58575u, 0x1290BA9A38C7D17Cu },
+    { 0x2DB2A7C57AE2E6D2u, 0x1734E940C6F9C5DCu }, { 0x391F51B6D99BA086u, 0x1D022390F8B83753u },
+    { 0x3B3931248014454u, 0x1221563A9B732294u }, { 0x4A077D6DA019569u, 0x16A9ABC9424FEB39u },
+    { 0x45C895CC9081FAC3u, 0x1C5416BB92E3E607u }, { 0x8B9D5D9FDA513CBAu, 0x11B48E353BCE6FC4u },
+    { 0xAE84B507D0E58BE8u, 0x1621B1C28AC20BB5u }, { 0x1A25E249C51EEEE3u, 0x1BAA1E332D728EA3u },
+    { 0xF057AD6E1B33554Du, 0x114A52DFFC679925u }, { 0x6C6D98C9A2002AA1u, 0x159CE797FB817F6Fu },
+    { 0x4788FEFC0A803549u, 0x1B04217DFA61DF4Bu }, { 0xCB59F5D8690214Eu, 0x10E294EEBC7D2B8Fu },
+    { 0xCFE30734E83429A1u, 0x151B3A2A6B9C7672u }, { 0x83DBC9022241340Au, 0x1A6208B50683940Fu },
+    { 0xB2695DA15568C086u, 0x107D457124123C89u }, { 0x1F03B509AAC2F0A7u, 0x149C96CD6D16CBACu },
+    { 0x26C4A24C1573ACD1u, 0x19C3BC80C85C7E97u }, { 0x783AE56F8D684C03u, 0x101A55D07D39CF1Eu },
+    { 0x16499ECB70C25F03u, 0x1420EB449C8842E6u }, { 0x9BDC067E4CF2F6C4u, 0x19292615C3AA539Fu },
+    { 0x82D3081DE02FB476u, 0x1F736F9B3494E887u }, { 0xB1C3E512AC1DD0C9u, 0x13A825C100DD1154u },
+    { 0xDE34DE57572544FCu, 0x18922F31411455A9u }, { 0x55C215ED2CEE963Bu, 0x1EB6BAFD91596B14u },
+    { 0xB5994DB43C151DE5u, 0x133234DE7AD7E2ECu }, { 0xE2FFA1214B1A655Eu, 0x17FEC216198DDBA7u },
+    { 0xDBBF89699DE0FEB6u, 0x1DFE729B9FF15291u }, { 0x2957B5E202AC9F31u, 0x12BF07A143F6D39Bu },
+    { 0xF3ADA35A8357C6FEu, 0x176EC98994F48881u }, { 0x70990C31242DB8BDu, 0x1D4A7BEBFA31AAA2u },
+    { 0x865FA79EB69C9376u, 0x124E8D737C5F0AA5u }, { 0xE7F791866443B854u, 0x16E230D05B76CD4Eu },
+    { 0xA1F575E7FD54A669u, 0x1C9ABD04725480A2u }, { 0xA53969B0FE54E801u, 0x11E0B622C774D065u },
+    { 0xE87C41D3DEA2202u, 0x1658E3AB7952047Fu }, { 0xD229B5248D64AA82u, 0x1BEF1C9657A6859Eu },
+    { 0x435A1136D85EEA91u, 0x117571DDF6C81383u }, { 0x143095848E76A536u, 0x15D2CE55747A1864u },
+    { 0x193CBAE5B2144E83u, 0x1B4781EAD1989E7Du }, { 0x2FC5F4CF8F4CB112u, 0x110CB132C2FF630Eu },
+    { 0xBBB77203731FDD56u, 0x154FDD7F73BF3BD1u }, { 0x2AA54E844FE7D4ACu, 0x1AA3D4DF50AF0AC6u },
+    { 0xDAA75112B1F0E4EBu, 0x10A6650B926D66BBu }, { 0xD15125575E6D1E26u, 0x14CFFE4E7708C06Au },
+    { 0x85A56EAD360865B0u, 0x1A03FDE214CAF085u }, { 0x7387652C41C53F8Eu, 0x10427EAD4CFED653u },
+    { 0x50693E7752368F71u, 0x14531E58A03E8BE8u }, { 0x64838E1526C4334Eu, 0x1967E5EEC84E2EE2u },
+    { 0xFDA4719A70754022u, 0x1FC1DF6A7A61BA9Au }, { 0xDE86C70086494815u, 0x13D92BA28C7D14A0u },
+    { 0x162878C0A7DB9A1Au, 0x18CF768B2F9C59C9u }, { 0x5BB296F0D1D280A1u, 0x1F03542DFB83703Bu },
+    { 0x194F9E5683239064u, 0x1362149CBD322625u }, { 0x5FA385EC23EC747Eu, 0x183A99C3EC7EAFAEu },
+    { 0xF78C67672CE7919Du, 0x1E494034E79E5B99u }, { 0x3AB7C0A07C10BB02u, 0x12EDC82110C2F940u },
+    { 0x4965B0C89B14E9C3u, 0x17A93A2954F3B790u }, { 0x5BBF1CFAC1DA2433u, 0x1D9388B3AA30A574u },
+    { 0xB957721CB92856A0u, 0x127C35704A5E6768u }, { 0xE7AD4EA3E7726C48u, 0x171B42CC5CF60142u },
+    { 0xA198A24CE14F075Au, 0x1CE2137F74338193u }, { 0x44FF65700CD16498u, 0x120D4C2FA8A030FCu },
+    { 0x563F3ECC1005BDBEu, 0x16909F3B92C83D3Bu }, { 0x2BCF0E7F14072D2Eu, 0x1C34C70A777A4C8Au },
+    { 0x5B61690F6C847C3Du, 0x11A0FC668AAC6FD6u }, { 0xF239C35347A59B4Cu, 0x16093B802D578BCBu },
+    { 0xEEC83428198F021Fu, 0x1B8B8A6038AD6EBEu }, { 0x553D20990FF96153u, 0x1137367C236C6537u },
+    { 0x2A8C68BF53F7B9A8u, 0x1585041B2C477E85u }, { 0x752F82EF28F5A812u, 0x1AE64521F7595E26u },
+    { 0x93DB1D57999890Bu, 0x10CFEB353A97DAD8u }, { 0xB8D1E4AD7FFEB4Eu, 0x1503E602893DD18Eu },
+    { 0x8E7065DD8DFFE622u, 0x1A44DF832B8D45F1u }, { 0xF9063FAA78BFEFD5u, 0x106B0BB1FB384BB6u },
+    { 0xB747CF9516EFEBCAu, 0x1485CE9E7A065EA4u }, { 0xE519C37A5CABE6BDu, 0x19A742461887F64Du },
+    { 0xAF301A2C79EB7036u, 0x1008896BCF54F9F0u }, { 0xDAFC20B798664C43u, 0x140AABC6C32A386Cu },
+    { 0x11BB28E57E7FDF54u, 0x190D56B873F4C688u }, { 0x1629F31EDE1FD72Au, 0x1F50AC6690F1F82Au },
+    { 0x4DDA37F34AD3E67Au, 0x13926BC01A973B1Au }, { 0xE150C5F01D88E019u, 0x187706B0213D09E0u },
+    { 0x19A4F76C24EB181Fu, 0x1E94C85C298C4C59u }, { 0xB0071AA39712EF13u, 0x131CFD3999F7AFB7u },
+    { 0x9C08E14C7CD7AAD8u, 0x17E43C8800759BA5u }, { 0x30B199F9C0D958Eu, 0x1DDD4BAA0093028Fu },
+    { 0x61E6F003C1887D79u, 0x12AA4F4A405BE199u }, { 0xBA60AC04B1EA9CD7u, 0x1754E31CD072D9FFu },
+    { 0xA8F8D705DE65440Du, 0x1D2A1BE4048F907Fu }, { 0xC99B8663AAFF4A88u, 0x123A516E82D9BA4Fu },
+    { 0xBC0267FC95BF1D2Au, 0x16C8E5CA239028E3u }, { 0xAB0301FBBB2EE474u, 0x1C7B1F3CAC74331Cu },
+    { 0xEAE1E13D54FD4EC9u, 0x11CCF385EBC89FF1u }, { 0x659A598CAA3CA27Bu, 0x1640306766BAC7EEu },
+    { 0xFF00EFEFD4CBCB1Au, 0x1BD03C81406979E9u }, { 0x3F6095F5E4FF5EF0u, 0x116225D0C841EC32u },
+    { 0xCF38BB735E3F36ACu, 0x15BAAF44FA52673Eu }, { 0x8306EA5035CF0457u, 0x1B295B1638E7010Eu },
+    { 0x11E4527221A162B6u, 0x10F9D8EDE39060A9u }, { 0x565D670EAA09BB64u, 0x15384F295C7478D3u },
+    { 0x2BF4C0D2548C2A3Du, 0x1A8662F3B3919708u }, { 0x1B78F88374D79A66u, 0x1093FDD8503AFE65u },
+    { 0x625736A4520D8100u, 0x14B8FD4E6449BDFEu }, { 0xFAED044D6690E140u, 0x19E73CA1FD5C2D7Du },
+    { 0xBCD422B0601A8CC8u, 0x103085E53E599C6Eu }, { 0x6C092B5C78212FFAu, 0x143CA75E8DF0038Au },
+    { 0x70B763396297BF8u, 0x194BD136316C046Du }, { 0x48CE53C07BB3DAF6u, 0x1F9EC583BDC70588u },
+    { 0x2D80F4584D5068DAu, 0x13C33B72569C6375u }, { 0x78E1316E60A48310u, 0x18B40A4EEC437C52u }
+};
+
+/**
+ * \struct string_builder_decimal_t
+ * \brief A decimal floating-point value: mantissa * 10^exponent.
+ */
+typedef struct
+{
+    uint64_t mantissa; /**< Decimal digits of the value. */
+    int32_t exponent; /**< Power of ten applied to the mantissa. */
+} string_builder_decimal_t;
+
+/**
+ * \brief Computes floor(log2(5^e)) + 1 for 0 <= e <= 3528.
+ *
+ * \param e Exponent of the power of five.
+ * \return Number of bits of 5^e.
+ */
+static inline int32_t pow5_bits_string_builder(const int32_t e)
+{
+    return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/**
+ * \brief Computes floor(log10(2^e)) for 0 <= e <= 1650.
+ *
+ * \param e Exponent of the power of two.
+ * \return Decimal logarithm of 2^e, rounded down.
+ */
+static inline uint32_t log10_pow2_string_builder(const int32_t e)
+{
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+/**
+ * \brief Computes floor(log10(5^e)) for 0 <= e <= 2620.
+ *
+ * \param e Exponent of the power of five.
+ * \return Decimal logarithm of 5^e, rounded down.
+ */
+static inline uint32_t log10_pow5_string_builder(const int32_t e)
+{
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+/**
+ * \brief Checks whether \p value is divisible by 5^p.
+ *
+ * \param value Value to inspect.
+ * \param p Exponent of the power of five.
+ * \return Nonzero if \p value is a multiple of 5^p.
+ */
+static inline int multiple_of_pow5_string_builder(uint64_t value, const uint32_t p)
+{
+    uint32_t count = 0;
+    while (value % 5 == 0 && value != 0)
+    {
+        value /= 5;
+        count++;
+    }
+
+    return count >= p;
+}
+
+/**
+ * \brief Checks whether \p value is divisible by 2^p.
+ *
+ * \param value Value to inspect.
+ * \param p Exponent of the power of two (less than 64).
+ * \return Nonzero if \p value is a multiple of 2^p.
+ */
+static inline int multiple_of_pow2_string_builder(const uint64_t value, const uint32_t p)
+{
+    return (value & (((uint64_t)1 << p) - 1)) == 0;
+}
+
+#if defined(__SIZEOF_INT128__) && !defined(STRING_BUILDER_NO_INT128)
+#   define STRING_BUILDER_INT128 1
+
+/**
+ * \brief Unsigned 128-bit integer (a compiler extension, hence __extension__).
+ */
+__extension__ typedef unsigned __int128 string_builder_uint128_t;
+#endif
+
+/**
+ * \brief Computes (m * mul) >> j, where mul is a 128-bit table entry.
+ *
+ * Uses 128-bit integers where the compiler has them, unless
+ * STRING_BUILDER_NO_INT128 is defined, and 64-bit halves otherwise.
+ *
+ * \param m Value to multiply (at most 55 bits).
+ * \param mul Low and high 64 bits of the multiplier.
+ * \param j Shift amount, between 64 and 127.
+ * \return The low 64 bits of the shifted product.
+ */
+static inline uint64_t mul_shift64_string_builder(const uint64_t m, const uint64_t *mul, const int32_t j)
+{
+#   ifdef STRING_BUILDER_INT128
+    const string_builder_uint128_t b0 = (string_builder_uint128_t)m * mul[0];
+    const string_builder_uint128_t b2 = (string_builder_uint128_t)m * mul[1];
+    return (uint64_t)(((b0 >> 64) + b2) >> (j - 64));
+#   else
+    // Multiply 64x64 -> 128 using 32-bit halves
+    const uint64_t m_lo = (uint32_t)m;
+    const uint64_t m_hi = m >> 32;
+    uint64_t words[2][2];
+    for (int k = 0; k < 2; k++)
+    {
+        const uint64_t b_lo = (uint32_t)mul[k];
+        const uint64_t b_hi = mul[k] >> 32;
+        const uint64_t lo_lo = m_lo * b_lo;
+        const uint64_t lo_hi = m_lo * b_hi;
+        const uint64_t hi_lo = m_hi * b_lo;
+        const uint64_t hi_hi = m_hi * b_hi;
+        const uint64_t mid = (lo_lo >> 32) + (uint32_t)lo_hi + (uint32_t)hi_lo;
+        words[k][0] = (mid << 32) | (uint32_t)lo_lo;
+        words[k][1] = hi_hi + (lo_hi >> 32) + (hi_lo >> 32) + (mid >> 32);
+    }
+
+    // Add the high half of the first product to the second product
+    const uint64_t sum = words[0][1] + words[1][0];
+    const uint64_t high = words[1][1] + (sum < words[0][1]);
+    const int32_t dist = j - 64;
+    return dist == 0 ? sum : (high << (64 - dist)) | (sum >> dist);
+#   endif
+}
+
+/**
+ * \brief Finds the shortest decimal that rounds back to a binary floating-point value.
+ *
+ * Implements the Ryu algorithm by Ulf Adams. The value is m2 * 2^e2, with the
+ * rounding interval given by \p mm_shift and \p accept_bounds. Works for any
+ * IEEE binary format up to double precision.
+ *
+ * \param m2 Binary mantissa (implicit bit included).
+ * \param e2 Binary exponent, already reduced by 2 for the interval bounds.
+ * \param mm_shift 1 unless the lower bound is closer because m2 is a power of two.
+ * \param accept_bounds Whether the interval bounds round back to the value (m2 is even).
+ * \return The shortest, closest decimal representation.
+ */
+static inline string_builder_decimal_t shortest_decimal_string_builder(
+    const uint64_t m2,
+    const int32_t e2,
+    const uint32_t mm_shift,
+    const int accept_bounds
+)
+{
+    // Compute the scaled interval [vm, vp] around vr
+    const uint64_t mv = 4 * m2;
+    uint64_t vr, vp, vm;
+    int32_t e10;
+    int vm_is_trailing_zeros = 0;
+    int vr_is_trailing_zeros = 0;
+
+    if (e2 >= 0)
+    {
+        const uint32_t q = log10_pow2_string_builder(e2) - (e2 > 3);
+        e10 = (int32_t)q;
+        const int32_t k = 125 + pow5_bits_string_builder((int32_t)q) - 1;
+        const int32_t i = -e2 + (int32_t)q + k;
+        vr = mul_shift64_string_builder(4 * m2, string_builder_pow5_inv_split[q], i);
+        vp = mul_shift64_string_builder(4 * m2 + 2, string_builder_pow5_inv_split[q], i);
+        vm = mul_shift64_string_builder(4 * m2 - 1 - mm_shift, string_builder_pow5_inv_split[q], i);
+
+        if (q <= 21)
+        {
+            // Only one of mp, mv, and mm can be a multiple of 5, if any
+            if (mv % 5 == 0)
+            {
+                vr_is_trailing_zeros = multiple_of_pow5_string_builder(mv, q);
+            }
+            else if (accept_bounds)
+            {
+                vm_is_trailing_zeros = multiple_of_pow5_string_builder(mv - 1 - mm_shift, q);
+            }
+            else
+            {
+                vp -= (uint64_t)multiple_of_pow5_string_builder(mv + 2, q);
+            }
+        }
+    }
+    else
+    {
+        const uint32_t q = log10_pow5_string_builder(-e2) - (-e2 > 1);
+        e10 = (int32_t)q + e2;
+        const int32_t i = -e2 - (int32_t)q;
+        const int32_t k = pow5_bits_string_builder(i) - 125;
+        const int32_t j = (int32_t)q - k;
+        vr = mul_shift64_string_builder(4 * m2, string_builder_pow5_split[i], j);
+        vp = mul_shift64_string_builder(4 * m2 + 2, string_builder_pow5_split[i], j);
+        vm = mul_shift64_string_builder(4 * m2 - 1 - mm_shift, string_builder_pow5_split[i], j);
+
+        if (q <= 1)
+        {
+            // mv has at least q trailing zero bits, so vr does too
+            vr_is_trailing_zeros = 1;
+            if (accept_bounds)
+            {
+                vm_is_trailing_zeros = mm_shift == 1;
+            }
+            else
+            {
+                --vp;
+            }
+        }
+        else if (q < 63)
+        {
+            vr_is_trailing_zeros = multiple_of_pow2_string_builder(mv, q);
+        }
+    }
+
+    // Remove digits while the interval still holds a shorter decimal
+    int32_t removed = 0;
+    uint32_t last_removed_digit = 0;
+    uint64_t output;
+
+    if (vm_is_trailing_zeros || vr_is_trailing_zeros)
+    {
+        // General case, which happens rarely
+        while (vp / 10 > vm / 10)
+        {
+            vm_is_trailing_zeros &= vm % 10 == 0;
+            vr_is_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = (uint32_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+
+        if (vm_is_trailing_zeros)
+        {
+            while (vm % 10 == 0)
+            {
+                vr_is_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = (uint32_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+
+        // Round even if the exact number is .....50..0
+        if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0)
+        {
+            last_removed_digit = 4;
+        }
+
+        output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) || last_removed_digit >= 5);
+    }
+    else
+    {
+        // Common case: no trailing zeros to track
+        int round_up = 0;
+        if (vp / 100 > vm / 100)
+        {
+            // Remove two digits at a time
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+
+        while (vp / 10 > vm / 10)
+        {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+
+        output = vr + (vr == vm || round_up);
+    }
+
+    string_builder_decimal_t result;
+    result.mantissa = output;
+    result.exponent = e10 + removed;
+    return result;
+}
+
+/**
+ * \brief Appends a decimal value in its shortest notation.
+ *
+ * Uses plain notation when the position of the decimal point relative to the
+ * leading digit satisfies -6 < point <= 21 (at most 21 integer digits, or at most
+ * 5 zeros between the point and the leading digit) and scientific notation
+ * (e.g. 1.5e+300) otherwise, the same way JavaScript and JSON do.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param negative Whether to write a minus sign.
+ * \param decimal Decimal value to append.
+ */
+static inline void write_decimal_string_builder(
+    string_builder_t *builder,
+    const int negative,
+    const string_builder_decimal_t decimal
+)
+{
+    // Render the digits once
+    char digits[20];
+    const int32_t length = (int32_t)count_digits_string_builder(decimal.mantissa);
+    format_u64_string_builder(digits + length, decimal.mantissa);
+
+    // Position of the decimal point relative to the leading digit
+    const int32_t point = decimal.exponent + length;
+    ensure_string_builder(builder, 32);
+    char *dest = builder->buf + builder->idx;
+
+    if (negative)
+    {
+        *dest++ = '-';
+    }
+
+    if (point > -6 && point <= 21)
+    {
+        if (point <= 0)
+        {
+            // 0.000ddd
+            *dest++ = '0';
+            *dest++ = '.';
+            memset(dest, '0', (size_t)-point);
+            dest += -point;
+            memcpy(dest, digits, (size_t)length);
+            dest += length;
+        }
+        else if (point >= length)
+        {
+            // ddd000
+            memcpy(dest, digits, (size_t)length);
+            dest += length;
+            memset(dest, '0', (size_t)(point - length));
+            dest += point - length;
+        }
+        else
+        {
+            // ddd.ddd
+            memcpy(dest, digits, (size_t)point);
+            dest += point;
+            *dest++ = '.';
+            memcpy(dest, digits + point, (size_t)(length - point));
+            dest += length - point;
+        }
+    }
+    else
+    {
+        // d.ddde+xx
+        *dest++ = digits[0];
+        if (length > 1)
+        {
+            *dest++ = '.';
+            memcpy(dest, digits + 1, (size_t)(length - 1));
+            dest += length - 1;
+        }
+
+        int32_t exponent = point - 1;
+        *dest++ = 'e';
+        *dest++ = exponent < 0 ? '-' : '+';
+        if (exponent < 0)
+        {
+            exponent = -exponent;
+        }
+
+        const size_t exponent_digits = count_digits_string_builder((uint64_t)exponent);
+        format_u64_string_builder(dest + exponent_digits, (uint64_t)exponent);
+        dest += exponent_digits;
+    }
+
+    builder->idx = (size_t)(dest - builder->buf);
+}
+
+/**
+ * \brief Appends nan, inf or -inf, or the sign of a zero.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param negative Whether the value is negative.
+ * \param is_zero Whether the value is a zero rather than a NaN or infinity.
+ * \param is_nan Whether the value is a NaN.
+ */
+static inline void write_special_float_string_builder(
+    string_builder_t *builder,
+    const int negative,
+    const int is_zero,
+    const int is_nan
+)
+{
+    if (is_nan)
+    {
+        write_string_builder_ranged(builder, "nan", 3);
+        return;
+    }
+
+    if (negative)
+    {
+        write_char_string_builder(builder, '-');
+    }
+
+    if (is_zero)
+    {
+        write_char_string_builder(builder, '0');
+    }
+    else
+    {
+        write_string_builder_ranged(builder, "inf", 3);
+    }
+}
+
+/**
+ * \brief Appends the shortest representation of a double that parses back to the same value.
+ *
+ * Converts straight into the buffer using the Ryu algorithm, without going through
+ * printf or the current locale. See write_decimal_string_builder for the notation.
+ * NaN and infinities are written as nan, inf and -inf.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ */
+static inline void write_double_string_builder(string_builder_t *builder, const double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    // Decode the IEEE representation
+    const int negative = (int)(bits >> 63);
+    const uint64_t ieee_mantissa = bits & (((uint64_t)1 << 52) - 1);
+    const uint32_t ieee_exponent = (uint32_t)((bits >> 52) & 0x7FF);
+
+    // Handle zeros, infinities and NaN
+    if (ieee_exponent == 0x7FF || (ieee_exponent == 0 && ieee_mantissa == 0))
+    {
+        write_special_float_string_builder(builder, negative, ieee_exponent == 0, ieee_mantissa != 0);
+        return;
+    }
+
+    int32_t e2;
+    uint64_t m2;
+    if (ieee_exponent == 0)
+    {
+        // Subnormal numbers
+        e2 = 1 - 1023 - 52 - 2;
+        m2 = ieee_mantissa;
+    }
+    else
+    {
+        e2 = (int32_t)ieee_exponent - 1023 - 52 - 2;
+        m2 = ((uint64_t)1 << 52) | ieee_mantissa;
+    }
+
+    const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+    write_decimal_string_builder(builder, negative, shortest_decimal_string_builder(m2, e2, mm_shift, (m2 & 1) == 0));
+}
+
+/**
+ * \brief Appends the shortest representation of a float that parses back to the same value.
+ *
+ * Same as write_double_string_builder, but the digits are chosen for single precision,
+ * so 0.1f is written as 0.1 rather than 0.10000000149011612.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ */
+static inline void write_float_string_builder(string_builder_t *builder, const float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    // Decode the IEEE representation
+    const int negative = (int)(bits >> 31);
+    const uint32_t ieee_mantissa = bits & ((1u << 23) - 1);
+    const uint32_t ieee_exponent = (bits >> 23) & 0xFF;
+
+    // Handle zeros, infinities and NaN
+    if (ieee_exponent == 0xFF || (ieee_exponent == 0 && ieee_mantissa == 0))
+    {
+        write_special_float_string_builder(builder, negative, ieee_exponent == 0, ieee_mantissa != 0);
+        return;
+    }
+
+    int32_t e2;
+    uint64_t m2;
+    if (ieee_exponent == 0)
+    {
+        // Subnormal numbers
+        e2 = 1 - 127 - 23 - 2;
+        m2 = ieee_mantissa;
+    }
+    else
+    {
+        e2 = (int32_t)ieee_exponent - 127 - 23 - 2;
+        m2 = (1u << 23) | ieee_mantissa;
+    }
+
+    const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+    write_decimal_string_builder(builder, negative, shortest_decimal_string_builder(m2, e2, mm_shift, (m2 & 1) == 0));
+}
+
+/**
+ * \brief Appends the output of vsnprintf, formatting straight into the buffer.
+ *
+ * Formats into the free space of the buffer first, and only reserves and formats
+ * again if the output did not fit.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param format printf format string.
+ * \param args Arguments for \p format.
+ */
+static inline void vprintf_tail_string_builder(string_builder_t *builder, const char *format, va_list args)
+{
+    va_list retry;
+    va_copy(retry, args);
+
+    // The null terminator slot is free to use as well
+    const size_t available = builder->capacity - builder->idx + 1;
+    const int written = vsnprintf(builder->buf + builder->idx, available, format, args);
+
+    if (written >= 0 && (size_t)written >= available && exceeds_stream_buffer_string_builder(builder, (size_t)written))
+    {
+        // Streaming builders format oversized output aside and pass it to the sink
+        char *tmp = (char *)alloc_mem_string_builder(builder->allocator, (size_t)written + 1);
+        if (tmp == NULL)
+        {
+            out_of_memory_string_builder("malloc");
+        }
+
+        vsnprintf(tmp, (size_t)written + 1, format, retry);
+        va_end(retry);
+        write_string_builder_ranged(builder, tmp, (size_t)written);
+        free_mem_string_builder(builder->allocator, tmp, (size_t)written + 1);
+        return;
+    }
+
+    // Retry with enough space if it did not fit
+    if (written >= 0 && (size_t)written >= available)
+    {
+        ensure_string_builder(builder, (size_t)written);
+        vsnprintf(builder->buf + builder->idx, (size_t)written + 1, format, retry);
+    }
+
+    va_end(retry);
+    if (written > 0)
+    {
+        builder->idx += (size_t)written;
+    }
+}
+
+/**
+ * \brief Appends the output of snprintf, formatting straight into the buffer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param format printf format string.
+ * \param ... Arguments for \p format.
+ */
+static inline void printf_tail_string_builder(string_builder_t *builder, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf_tail_string_builder(builder, format, args);
+    va_end(args);
+}
+
+/**
+ * \brief Appends a double in fixed notation with \p precision digits after the decimal point.
+ *
+ * Equivalent to printf's %.*f, written directly into the buffer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ * \param precision Number of digits after the decimal point.
+ */
+static inline void write_double_fixed_string_builder(string_builder_t *builder, const double value, const int precision)
+{
+    printf_tail_string_builder(builder, "%.*f", precision, value);
+}
+
+/**
+ * \brief Appends a double in scientific notation with \p precision digits after the decimal point.
+ *
+ * Equivalent to printf's %.*e, written directly into the buffer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param value Value to append.
+ * \param precision Number of digits after the decimal point.
+ */
+static inline void write_double_scientific_string_builder(string_builder_t *builder, const double value, const int precision)
+{
+    printf_tail_string_builder(builder, "%.*e", precision, value);
+}
+
+/**
+ * \enum string_builder_length_t
+ * \brief Length modifiers of a printf conversion.
+ */
+typedef enum
+{
+    STRING_BUILDER_LENGTH_NONE, /**< No modifier. */
+    STRING_BUILDER_LENGTH_HH, /**< hh: char. */
+    STRING_BUILDER_LENGTH_H, /**< h: short. */
+    STRING_BUILDER_LENGTH_L, /**< l: long. */
+    STRING_BUILDER_LENGTH_LL, /**< ll: long long. */
+    STRING_BUILDER_LENGTH_Z, /**< z: size_t. */
+    STRING_BUILDER_LENGTH_J, /**< j: intmax_t. */
+    STRING_BUILDER_LENGTH_T, /**< t: ptrdiff_t. */
+    STRING_BUILDER_LENGTH_LONG_DOUBLE /**< L: long double. */
+} string_builder_length_t;
+
+/**
+ * \brief Reads a signed integer argument of the given length.
+ *
+ * \param args Pointer to the argument list.
+ * \param length Length modifier of the conversion.
+ * \return The argument, converted to intmax_t.
+ */
+static inline intmax_t read_signed_arg_string_builder(va_list *args, const string_builder_length_t length)
+{
+    switch (length)
+    {
+        case STRING_BUILDER_LENGTH_HH: return (signed char)va_arg(*args, int);
+        case STRING_BUILDER_LENGTH_H: return (short)va_arg(*args, int);
+        case STRING_BUILDER_LENGTH_L: return va_arg(*args, long);
+        case STRING_BUILDER_LENGTH_LL: return va_arg(*args, long long);
+        case STRING_BUILDER_LENGTH_Z: return va_arg(*args, ptrdiff_t);
+        case STRING_BUILDER_LENGTH_J: return va_arg(*args, intmax_t);
+        case STRING_BUILDER_LENGTH_T: return va_arg(*args, ptrdiff_t);
+        default: return va_arg(*args, int);
+    }
+}
+
+/**
+ * \brief Reads an unsigned integer argument of the given length.
+ *
+ * \param args Pointer to the argument list.
+ * \param length Length modifier of the conversion.
+ * \return The argument, converted to uintmax_t.
+ */
+static inline uintmax_t read_unsigned_arg_string_builder(va_list *args, const string_builder_length_t length)
+{
+    switch (length)
+    {
+        case STRING_BUILDER_LENGTH_HH: return (unsigned char)va_arg(*args, unsigned int);
+        case STRING_BUILDER_LENGTH_H: return (unsigned short)va_arg(*args, unsigned int);
+        case STRING_BUILDER_LENGTH_L: return va_arg(*args, unsigned long);
+        case STRING_BUILDER_LENGTH_LL: return va_arg(*args, unsigned long long);
+        case STRING_BUILDER_LENGTH_Z: return va_arg(*args, size_t);
+        case STRING_BUILDER_LENGTH_J: return va_arg(*args, uintmax_t);
+        case STRING_BUILDER_LENGTH_T: return va_arg(*args, size_t);
+        default: return va_arg(*args, unsigned int);
+    }
+}
+
+/**
+ * \brief Parses a non-negative decimal number, advancing the cursor past it.
+ *
+ * \param cursor Pointer to the format cursor.
+ * \return The parsed number (digits past the ninth are ignored).
+ */
+static inline int parse_format_number_string_builder(const char **cursor)
+{
+    int value = 0;
+    while (**cursor >= '0' && **cursor <= '9')
+    {
+        if (value < 100000000)
+        {
+            value = value * 10 + (**cursor - '0');
+        }
+
+        (*cursor)++;
+    }
+
+    return value;
+}
+
+/**
+ * \brief Appends formatted output, like vsprintf, directly into the builder.
+ *
+ * Plain %d %i %u %x %X %o %c %s %% conversions (with any length modifier, and
+ * a precision for %s such as %.*s) are handled by the builder's own kernels.
+ * Conversions with flags or a width, floating-point conversions and %p are
+ * formatted by vsnprintf straight into the buffer, one conversion at a time.
+ * %n is not supported and its argument is skipped.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param format printf format string.
+ * \param args Arguments for \p format.
+ */
+static inline void vformat_string_builder(string_builder_t *builder, const char *format, va_list args)
+{
+    va_list ap;
+    va_copy(ap, args);
+
+    const char *cursor = format;
+    while (*cursor != '\0')
+    {
+        // Copy the literal run up to the next conversion
+        const char *percent = strchr(cursor, '%');
+        if (percent == NULL)
+        {
+            write_string_builder(builder, cursor);
+            break;
+        }
+
+        write_string_builder_ranged(builder, cursor, (size_t)(percent - cursor));
+        cursor = percent + 1;
+
+        // Parse the flags
+        const char *flags = cursor;
+        while (*cursor == '-' || *cursor == '+' || *cursor == ' ' || *cursor == '#' || *cursor == '0')
+        {
+            cursor++;
+        }
+
+        const size_t flags_len = (size_t)(cursor - flags);
+        int left_align = memchr(flags, '-', flags_len) != NULL;
+
+        // Parse the width
+        int width = -1;
+        if (*cursor == '*')
+        {
+            width = va_arg(ap, int);
+            if (width < 0)
+            {
+                // A negative width means left alignment
+                left_align = 1;
+                width = width == INT_MIN ? INT_MAX : -width;
+            }
+
+            cursor++;
+        }
+        else if (*cursor >= '0' && *cursor <= '9')
+        {
+            width = parse_format_number_string_builder(&cursor);
+        }
+
+        // Parse the precision
+        int precision = -1;
+        if (*cursor == '.')
+        {
+            cursor++;
+            if (*cursor == '*')
+            {
+                // A negative precision counts as omitted
+                precision = va_arg(ap, int);
+                precision = precision < 0 ? -1 : precision;
+                cursor++;
+            }
+            else
+            {
+                precision = parse_format_number_string_builder(&cursor);
+            }
+        }
+
+        // Parse the length modifier
+        string_builder_length_t length = STRING_BUILDER_LENGTH_NONE;
+        switch (*cursor)
+        {
+            case 'h':
+                length = cursor[1] == 'h' ? STRING_BUILDER_LENGTH_HH : STRING_BUILDER_LENGTH_H;
+                cursor += cursor[1] == 'h' ? 2 : 1;
+                break;
+            case 'l':
+                length = cursor[1] == 'l' ? STRING_BUILDER_LENGTH_LL : STRING_BUILDER_LENGTH_L;
+                cursor += cursor[1] == 'l' ? 2 : 1;
+                break;
+            case 'z': length = STRING_BUILDER_LENGTH_Z; cursor++; break;
+            case 'j': length = STRING_BUILDER_LENGTH_J; cursor++; break;
+            case 't': length = STRING_BUILDER_LENGTH_T; cursor++; break;
+            case 'L': length = STRING_BUILDER_LENGTH_LONG_DOUBLE; cursor++; break;
+            default: break;
+        }
+
+        const char conversion = *cursor;
+        if (conversion == '\0')
+        {
+            // Dangling specification, nothing to convert
+            break;
+        }
+
+        cursor++;
+
+        // Fast path: no flags or width
+        const int plain = flags_len == 0 && width < 0 && !left_align;
+        if (plain && length != STRING_BUILDER_LENGTH_LONG_DOUBLE)
+        {
+            if (conversion == '%')
+            {
+                write_char_string_builder(builder, '%');
+                continue;
+            }
+
+            if ((conversion == 'd' || conversion == 'i') && precision < 0)
+            {
+                write_i64_string_builder(builder, (int64_t)read_signed_arg_string_builder(&ap, length));
+                continue;
+            }
+
+            if ((conversion == 'u' || conversion == 'x' || conversion == 'X' || conversion == 'o') && precision < 0)
+            {
+                const uint64_t value = (uint64_t)read_unsigned_arg_string_builder(&ap, length);
+                if (conversion == 'u')
+                {
+                    write_u64_string_builder(builder, value);
+                }
+                else if (conversion == 'o')
+                {
+                    write_oct_u64_string_builder(builder, value);
+                }
+                else
+                {
+                    write_hex_u64_string_builder(builder, value, conversion == 'X');
+                }
+
+                continue;
+            }
+
+            if (conversion == 'c' && length == STRING_BUILDER_LENGTH_NONE)
+            {
+                write_char_string_builder(builder, (char)va_arg(ap, int));
+                continue;
+            }
+
+            if (conversion == 's' && length == STRING_BUILDER_LENGTH_NONE)
+            {
+                const char *str = va_arg(ap, const char *);
+                if (str == NULL)
+                {
+                    str = "(null)";
+                }
+
+                // A precision bounds the string, which need not be null-terminated
+                if (precision >= 0)
+                {
+                    const char *nul = (const char *)memchr(str, '\0', (size_t)precision);
+                    write_string_builder_ranged(builder, str, nul == NULL ? (size_t)precision : (size_t)(nul - str));
+                }
+                else
+                {
+                    write_string_builder(builder, str);
+                }
+
+                continue;
+            }
+        }
+
+        // Rebuild a single conversion with every '*' resolved
+        char spec[64];
+        size_t spec_len = 0;
+        spec[spec_len++] = '%';
+        if (left_align && memchr(flags, '-', flags_len) == NULL)
+        {
+            spec[spec_len++] = '-';
+        }
+
+        memcpy(spec + spec_len, flags, flags_len < 8 ? flags_len : 8);
+        spec_len += flags_len < 8 ? flags_len : 8;
+        if (width >= 0)
+        {
+            spec_len += (size_t)snprintf(spec + spec_len, 12, "%d", width);
+        }
+
+        if (precision >= 0)
+        {
+            spec_len += (size_t)snprintf(spec + spec_len, 13, ".%d", precision);
+        }
+
+        switch (conversion)
+        {
+            case 'd':
+            case 'i':
+                spec[spec_len++] = 'j';
+                spec[spec_len++] = conversion;
+                spec[spec_len] = '\0';
+                printf_tail_string_builder(builder, spec, read_signed_arg_string_builder(&ap, length));
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                spec[spec_len++] = 'j';
+                spec[spec_len++] = conversion;
+                spec[spec_len] = '\0';
+                printf_tail_string_builder(builder, spec, read_unsigned_arg_string_builder(&ap, length));
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if (length == STRING_BUILDER_LENGTH_LONG_DOUBLE)
+                {
+                    spec[spec_len++] = 'L';
+                    spec[spec_len++] = conversion;
+                    spec[spec_len] = '\0';
+                    printf_tail_string_builder(builder, spec, va_arg(ap, long double));
+                }
+                else
+                {
+                    spec[spec_len++] = conversion;
+                    spec[spec_len] = '\0';
+                    printf_tail_string_builder(builder, spec, va_arg(ap, double));
+                }
+                break;
+            case 'c':
+                if (length == STRING_BUILDER_LENGTH_L)
+                {
+                    spec[spec_len++] = 'l';
+                    spec[spec_len++] = 'c';
+                    spec[spec_len] = '\0';
+                    printf_tail_string_builder(builder, spec, va_arg(ap, wint_t));
+                }
+                else
+                {
+                    spec[spec_len++] = 'c';
+                    spec[spec_len] = '\0';
+                    printf_tail_string_builder(builder, spec, va_arg(ap, int));
+                }
+                break;
+            case 's':
+                if (length == STRING_BUILDER_LENGTH_L)
+                {
+                    spec[spec_len++] = 'l';
+                    spec[spec_len++] = 's';
+                    spec[spec_len] = '\0';
+                    printf_tail_string_builder(builder, spec, va_arg(ap, const wchar_t *));
+                }
+                else
+                {
+                    const char *str = va_arg(ap, const char *);
+                    spec[spec_len++] = 's';
+                    spec[spec_len] = '\0';
+                    printf_tail_string_builder(builder, spec, str == NULL ? "(null)" : str);
+                }
+                break;
+            case 'p':
+                spec[spec_len++] = 'p';
+                spec[spec_len] = '\0';
+                printf_tail_string_builder(builder, spec, va_arg(ap, void *));
+                break;
+            case 'n':
+                // Not supported, skip the argument
+                (void)va_arg(ap, void *);
+                break;
+            case '%':
+                write_char_string_builder(builder, '%');
+                break;
+            default:
+                // Unknown conversion, copy it verbatim
+                write_string_builder_ranged(builder, percent, (size_t)(cursor - percent));
+                break;
+        }
+    }
+
+    va_end(ap);
+}
+
+/**
+ * \brief Appends formatted output, like sprintf, directly into the builder.
+ *
+ * See vformat_string_builder for the supported conversions.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param format printf format string.
+ * \param ... Arguments for \p format.
+ */
+static inline void format_string_builder(string_builder_t *builder, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vformat_string_builder(builder, format, args);
+    va_end(args);
+}
+
+/**
+ * \brief Counts the trailing zero bits of a non-zero mask.
+ *
+ * \param mask Mask to inspect (must not be 0).
+ * \return Index of the lowest set bit.
+ */
+static inline size_t count_trailing_zeros_string_builder(const uint32_t mask)
+{
+#   if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_ctz(mask);
+#   elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (size_t)index;
+#   else
+    size_t index = 0;
+    while (!(mask & (1u << index)))
+    {
+        index++;
+    }
+
+    return index;
+#   endif
+}
+
+/**
+ * \brief Checks whether a byte belongs to a scan set.
+ *
+ * \param c Byte to check.
+ * \param needles Bytes to look for.
+ * \param needle_count Number of bytes in \p needles.
+ * \param match_control Whether control characters (0x00-0x1F) are part of the set.
+ * \param match_high Whether DEL and non-ASCII bytes (0x7F-0xFF) are part of the set.
+ * \return Nonzero if \p c belongs to the set.
+ */
+static inline int is_scan_byte_string_builder(
+    const unsigned char c,
+    const char *needles,
+    const size_t needle_count,
+    const int match_control,
+    const int match_high
+)
+{
+    if (match_control && c < 0x20) return 1;
+    if (match_high && c >= 0x7F) return 1;
+
+    for (size_t k = 0; k < needle_count; k++)
+    {
+        if (c == (unsigned char)needles[k]) return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Finds the first byte that belongs to a scan set.
+ *
+ * Scans 32 bytes at a time with AVX2 or 16 bytes at a time with SSE2 when
+ * available, and falls back to a byte-by-byte loop for the tail and other targets.
+ * Used by the escaping kernels to bulk-copy runs of bytes that need no escaping.
+ *
+ * \param str Pointer to the bytes to scan.
+ * \param n Number of bytes to scan.
+ * \param needles Bytes to look for.
+ * \param needle_count Number of bytes in \p needles.
+ * \param match_control Whether control characters (0x00-0x1F) are part of the set.
+ * \param match_high Whether DEL and non-ASCII bytes (0x7F-0xFF) are part of the set.
+ * \return Index of the first matching byte, or \p n if there is none.
+ */
+static inline size_t scan_bytes_string_builder(
+    const char *str,
+    const size_t n,
+    const char *needles,
+    const size_t needle_count,
+    const int match_control,
+    const int match_high
+)
+{
+    size_t i = 0;
+
+#   ifdef STRING_BUILDER_AVX2
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i *)(str + i));
+        __m256i hit = _mm256_setzero_si256();
+        for (size_t k = 0; k < needle_count; k++)
+        {
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(needles[k])));
+        }
+
+        if (match_control)
+        {
+            // chunk <= 0x1F, unsigned
+            const __m256i limit = _mm256_set1_epi8(0x1F);
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, limit), limit));
+        }
+
+        if (match_high)
+        {
+            // chunk >= 0x7F, unsigned
+            const __m256i limit = _mm256_set1_epi8(0x7F);
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, limit), chunk));
+        }
+
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(hit);
+        if (mask != 0)
+        {
+            return i + count_trailing_zeros_string_builder(mask);
+        }
+    }
+#   endif
+
+#   ifdef STRING_BUILDER_SSE2
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *)(str + i));
+        __m128i hit = _mm_setzero_si128();
+        for (size_t k = 0; k < needle_count; k++)
+        {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(needles[k])));
+        }
+
+        if (match_control)
+        {
+            // chunk <= 0x1F, unsigned
+            const __m128i limit = _mm_set1_epi8(0x1F);
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_max_epu8(chunk, limit), limit));
+        }
+
+        if (match_high)
+        {
+            // chunk >= 0x7F, unsigned
+            const __m128i limit = _mm_set1_epi8(0x7F);
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_max_epu8(chunk, limit), chunk));
+        }
+
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+        if (mask != 0)
+        {
+            return i + count_trailing_zeros_string_builder(mask);
+        }
+    }
+#   endif
+
+    for (; i < n; i++)
+    {
+        if (is_scan_byte_string_builder((unsigned char)str[i], needles, needle_count, match_control, match_high))
+        {
+            return i;
+        }
+    }
+
+    return n;
+}
+
+/**
+ * \brief Appends a string with JSON escaping applied (without surrounding quotes).
+ *
+ * Runs without quotes, backslashes or control characters are found with
+ * scan_bytes_string_builder and copied in bulk; only the special bytes are escaped,
+ * using the short forms (\\n, \\t, ...) where JSON has them and \\u00XX otherwise.
+ * Non-ASCII bytes are copied as they are.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the source string (not necessarily null-terminated).
+ * \param n Number of characters to escape from \p str.
+ */
+static inline void write_json_escaped_string_builder(string_builder_t *builder, const char *str, const size_t n)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        // Copy the clean run in bulk
+        const size_t run = scan_bytes_string_builder(str + i, n - i, "\"\\", 2, 1, 0);
+        if (run > 0)
+        {
+            write_string_builder_ranged(builder, str + i, run);
+            i += run;
+        }
+
+        if (i == n)
+        {
+            break;
+        }
+
+        // Escape the special byte
+        const unsigned char c = (unsigned char)str[i++];
+        ensure_string_builder(builder, 6);
+        char *dest = builder->buf + builder->idx;
+        dest[0] = '\\';
+
+        char short_form = 0;
+        switch (c)
+        {
+            case '"': short_form = '"'; break;
+            case '\\': short_form = '\\'; break;
+            case '\b': short_form = 'b'; break;
+            case '\f': short_form = 'f'; break;
+            case '\n': short_form = 'n'; break;
+            case '\r': short_form = 'r'; break;
+            case '\t': short_form = 't'; break;
+            default: break;
+        }
+
+        if (short_form != 0)
+        {
+            dest[1] = short_form;
+            builder->idx += 2;
+        }
+        else
+        {
+            memcpy(dest + 1, "u00", 3);
+            dest[4] = string_builder_hex_digits[0][c >> 4];
+            dest[5] = string_builder_hex_digits[0][c & 0xF];
+            builder->idx += 6;
+        }
+    }
+}
+
+/**
+ * \brief Returns the HTML entity that replaces a special character, if any.
+ *
+ * \param c Character to look up.
+ * \param len Output for the length of the entity.
+ * \return The entity, or NULL if \p c needs no escaping.
+ */
+static inline const char *html_entity_string_builder(const char c, size_t *len)
+{
+    switch (c)
+    {
+        case '<': *len = 4; return "&lt;";
+        case '>': *len = 4; return "&gt;";
+        case '&': *len = 5; return "&amp;";
+        case '"': *len = 6; return "&quot;";
+        case '\'': *len = 5; return "&#39;";
+        default: *len = 1; return NULL;
+    }
+}
+
+/**
+ * \brief Appends a string with HTML/XML entity escaping applied.
+ *
+ * Replaces <, >, &, " and ' with their entities. The input is processed in blocks
+ * of STRING_BUILDER_ESCAPE_BLOCK bytes (smaller for streaming builders, so that
+ * a block always fits the buffer): the escaped length of a block is computed
+ * first, the space is reserved once, and the block is written in a single pass.
+ * Both passes skip clean runs with scan_bytes_string_builder.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the source string (not necessarily null-terminated).
+ * \param n Number of characters to escape from \p str.
+ */
+static inline void write_html_escaped_string_builder(string_builder_t *builder, const char *str, const size_t n)
+{
+    static const char specials[] = "<>&\"'";
+
+    size_t offset = 0;
+    while (offset < n)
+    {
+        const char *block = str + offset;
+        const size_t block_size = escape_block_string_builder(builder, 6);
+        const size_t block_len = n - offset < block_size ? n - offset : block_size;
+
+        // Compute the escaped length of the block
+        size_t escaped_len = block_len;
+        size_t i = 0;
+        for (;;)
+        {
+            i += scan_bytes_string_builder(block + i, block_len - i, specials, 5, 0, 0);
+            if (i == block_len) break;
+
+            size_t entity_len;
+            html_entity_string_builder(block[i++], &entity_len);
+            escaped_len += entity_len - 1;
+        }
+
+        // Reserve once and write the block
+        ensure_string_builder(builder, escaped_len);
+        char *dest = builder->buf + builder->idx;
+        i = 0;
+        for (;;)
+        {
+            const size_t run = scan_bytes_string_builder(block + i, block_len - i, specials, 5, 0, 0);
+            memcpy(dest, block + i, run);
+            dest += run;
+            i += run;
+            if (i == block_len) break;
+
+            size_t entity_len;
+            const char *entity = html_entity_string_builder(block[i++], &entity_len);
+            memcpy(dest, entity, entity_len);
+            dest += entity_len;
+        }
+
+        builder->idx += escaped_len;
+        offset += block_len;
+    }
+}
+
+/**
+ * \brief Encodes a code point as UTF-8.
+ *
+ * Surrogates and values above U+10FFFF are encoded as U+FFFD instead.
+ *
+ * \param dest Destination with room for at least 4 bytes.
+ * \param codepoint Code point to encode.
+ * \return Number of bytes written (1 to 4).
+ */
+static inline size_t encode_utf8_string_builder(char *dest, uint32_t codepoint)
+{
+    if (codepoint < 0x80)
+    {
+        dest[0] = (char)codepoint;
+        return 1;
+    }
+
+    if (codepoint < 0x800)
+    {
+        dest[0] = (char)(0xC0 | (codepoint >> 6));
+        dest[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+
+    // Replace values that are not Unicode scalar values
+    if ((codepoint >= 0xD800 && codepoint <= 0xDFFF) || codepoint > 0x10FFFF)
+    {
+        codepoint = 0xFFFD;
+    }
+
+    if (codepoint < 0x10000)
+    {
+        dest[0] = (char)(0xE0 | (codepoint >> 12));
+        dest[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        dest[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+
+    dest[0] = (char)(0xF0 | (codepoint >> 18));
+    dest[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    dest[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    dest[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+/**
+ * \brief Appends a Unicode code point encoded as UTF-8.
+ *
+ * Surrogates and values above U+10FFFF are written as U+FFFD.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param codepoint Code point to append.
+ */
+static inline void write_codepoint_string_builder(string_builder_t *builder, const uint32_t codepoint)
+{
+    // Fast path: ASCII
+    if (codepoint < 0x80)
+    {
+        write_char_string_builder(builder, (char)codepoint);
+        return;
+    }
+
+    ensure_string_builder(builder, 4);
+    builder->idx += encode_utf8_string_builder(builder->buf + builder->idx, codepoint);
+}
+
+/**
+ * \brief Appends a string escaped for use inside a C (or Fluent) string literal.
+ *
+ * Printable ASCII runs are found with scan_bytes_string_builder and copied in bulk.
+ * Quotes and backslashes get a backslash, common control characters use their
+ * short escapes (\\n, \\t, ...) and every other non-printable or non-ASCII byte
+ * becomes a three-digit octal escape, which can never swallow a following digit
+ * the way hexadecimal escapes do. A '?' that follows another '?' is written as \\?
+ * so the output never contains trigraphs. Surrounding quotes are not written.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the source string (not necessarily null-terminated).
+ * \param n Number of characters to escape from \p str.
+ */
+static inline void write_c_escaped_string_builder(string_builder_t *builder, const char *str, const size_t n)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        // Copy the printable run in bulk
+        const size_t run = scan_bytes_string_builder(str + i, n - i, "\"\\?", 3, 1, 1);
+        if (run > 0)
+        {
+            write_string_builder_ranged(builder, str + i, run);
+            i += run;
+        }
+
+        if (i == n)
+        {
+            break;
+        }
+
+        // Escape the special byte
+        const unsigned char c = (unsigned char)str[i];
+        ensure_string_builder(builder, 4);
+        char *dest = builder->buf + builder->idx;
+
+        char short_form = 0;
+        switch (c)
+        {
+            case '"': short_form = '"'; break;
+            case '\\': short_form = '\\'; break;
+            case '\a': short_form = 'a'; break;
+            case '\b': short_form = 'b'; break;
+            case '\f': short_form = 'f'; break;
+            case '\n': short_form = 'n'; break;
+            case '\r': short_form = 'r'; break;
+            case '\t': short_form = 't'; break;
+            case '\v': short_form = 'v'; break;
+            case '?':
+                // Only break up potential trigraphs
+                short_form = i > 0 && str[i - 1] == '?' ? '?' : 0;
+                if (short_form == 0)
+                {
+                    dest[0] = '?';
+                    builder->idx++;
+                    i++;
+                    continue;
+                }
+                break;
+            default: break;
+        }
+
+        dest[0] = '\\';
+        if (short_form != 0)
+        {
+            dest[1] = short_form;
+            builder->idx += 2;
+        }
+        else
+        {
+            dest[1] = (char)('0' + (c >> 6));
+            dest[2] = (char)('0' + ((c >> 3) & 7));
+            dest[3] = (char)('0' + (c & 7));
+            builder->idx += 4;
+        }
+
+        i++;
+    }
+}
+
+/**
+ * \brief Returns the value of a hexadecimal digit.
+ *
+ * \param c Character to convert.
+ * \return The value of the digit, or -1 if \p c is not a hexadecimal digit.
+ */
+static inline int hex_value_string_builder(const char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * \brief Reads one C escape sequence.
+ *
+ * \param str Pointer to the literal contents.
+ * \param n Number of characters in \p str.
+ * \param i Position just past the backslash, advanced past the sequence.
+ * \param value Receives the byte or code point the sequence stands for.
+ * \return 0 for a byte, 1 for a code point to write as UTF-8, -1 if the sequence is malformed.
+ */
+static inline int read_c_escape_string_builder(const char *str, const size_t n, size_t *i, uint32_t *value)
+{
+    if (*i == n)
+    {
+        return -1;
+    }
+
+    const char c = str[(*i)++];
+    switch (c)
+    {
+        case 'a': *value = '\a'; return 0;
+        case 'b': *value = '\b'; return 0;
+        case 'f': *value = '\f'; return 0;
+        case 'n': *value = '\n'; return 0;
+        case 'r': *value = '\r'; return 0;
+        case 't': *value = '\t'; return 0;
+        case 'v': *value = '\v'; return 0;
+        case '\\':
+        case '\'':
+        case '"':
+        case '?':
+            *value = (unsigned char)c;
+            return 0;
+        case 'x':
+        {
+            // At least one hexadecimal digit, and the value must fit in a byte
+            size_t digits = 0;
+            *value = 0;
+            while (*i < n && hex_value_string_builder(str[*i]) >= 0)
+            {
+                *value = (*value << 4) | (uint32_t)hex_value_string_builder(str[(*i)++]);
+                if (*value > 0xFF)
+                {
+                    return -1;
+                }
+
+                digits++;
+            }
+
+            return digits == 0 ? -1 : 0;
+        }
+        case 'u':
+        case 'U':
+        {
+            // Exactly 4 or 8 hexadecimal digits
+            const size_t digits = c == 'u' ? 4 : 8;
+            if (n - *i < digits)
+            {
+                return -1;
+            }
+
+            *value = 0;
+            for (size_t k = 0; k < digits; k++)
+            {
+                const int digit = hex_value_string_builder(str[(*i)++]);
+                if (digit < 0)
+                {
+                    return -1;
+                }
+
+                *value = (*value << 4) | (uint32_t)digit;
+            }
+
+            return (*value >= 0xD800 && *value <= 0xDFFF) || *value > 0x10FFFF ? -1 : 1;
+        }
+        default:
+            if (c >= '0' && c <= '7')
+            {
+                // Up to three octal digits
+                *value = (uint32_t)(c - '0');
+                for (int k = 0; k < 2 && *i < n && str[*i] >= '0' && str[*i] <= '7'; k++)
+                {
+                    *value = (*value << 3) | (uint32_t)(str[(*i)++] - '0');
+                }
+
+                return *value > 0xFF ? -1 : 0;
+            }
+
+            return -1;
+    }
+}
+
+/**
+ * \brief Appends the contents of a C string literal with its escapes resolved.
+ *
+ * The inverse of write_c_escaped_string_builder. Understands the simple escapes,
+ * octal escapes (up to three digits), hexadecimal escapes (\\x followed by any
+ * number of digits) and universal character names (\\u and \\U), which are
+ * written as UTF-8. Runs without backslashes are copied in bulk.
+ * If the input is malformed, nothing is appended and -1 is returned: streaming
+ * builders check every escape before writing, as drained output cannot be taken
+ * back, and other builders are truncated back to their original length.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the literal contents (without surrounding quotes).
+ * \param n Number of characters to read from \p str.
+ * \return 0 on success, -1 if \p str contains an invalid escape sequence.
+ */
+static inline int write_c_unescaped_string_builder(string_builder_t *builder, const char *str, const size_t n)
+{
+    uint32_t value;
+    size_t i = 0;
+
+    if (builder->sink != NULL)
+    {
+        // Validate up front, drained output cannot be rolled back
+        while (i < n)
+        {
+            i += scan_bytes_string_builder(str + i, n - i, "\\", 1, 0, 0);
+            if (i == n)
+            {
+                break;
+            }
+
+            i++;
+            if (read_c_escape_string_builder(str, n, &i, &value) < 0)
+            {
+                return -1;
+            }
+        }
+
+        i = 0;
+    }
+
+    const size_t start = builder->idx;
+    while (i < n)
+    {
+        // Copy the run up to the next backslash in bulk
+        const size_t run = scan_bytes_string_builder(str + i, n - i, "\\", 1, 0, 0);
+        if (run > 0)
+        {
+            write_string_builder_ranged(builder, str + i, run);
+            i += run;
+        }
+
+        if (i == n)
+        {
+            break;
+        }
+
+        // Resolve the escape sequence
+        i++;
+        const int kind = read_c_escape_string_builder(str, n, &i, &value);
+        if (kind < 0)
+        {
+            truncate_string_builder(builder, start);
+            return -1;
+        }
+
+        if (kind == 0)
+        {
+            write_char_string_builder(builder, (char)value);
+        }
+        else
+        {
+            ensure_string_builder(builder, 4);
+            builder->idx += encode_utf8_string_builder(builder->buf + builder->idx, value);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Appends a single CSV/TSV field, quoted as described by RFC 4180.
+ *
+ * The field is scanned once for separators, quotes and line breaks; a field that
+ * needs no quoting is copied as it is, otherwise the quoted length (including the
+ * doubled quotes) is computed from the same scan, reserved once and written in
+ * a single pass. Fields larger than the buffer of a streaming builder are
+ * written run by run instead.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the field contents (not necessarily null-terminated).
+ * \param n Number of characters in the field.
+ * \param separator Field separator (e.g. ',' for CSV or '\\t' for TSV).
+ */
+static inline void write_csv_field_string_builder(
+    string_builder_t *builder,
+    const char *str,
+    const size_t n,
+    const char separator
+)
+{
+    const char specials[4] = { separator, '"', '\n', '\r' };
+
+    // Find out whether the field needs quoting and how many quotes it has
+    size_t i = scan_bytes_string_builder(str, n, specials, 4, 0, 0);
+    if (i == n)
+    {
+        write_string_builder_ranged(builder, str, n);
+        return;
+    }
+
+    size_t quotes = 0;
+    while (i < n)
+    {
+        if (str[i] == '"')
+        {
+            quotes++;
+        }
+
+        i++;
+        i += scan_bytes_string_builder(str + i, n - i, "\"", 1, 0, 0);
+    }
+
+    // Make sure the quoted length does not overflow
+    const size_t total = add_size_string_builder(add_size_string_builder(n, quotes), 2);
+
+    // Streaming builders keep their buffer size, write the field run by run
+    if (exceeds_stream_buffer_string_builder(builder, total))
+    {
+        write_char_string_builder(builder, '"');
+
+        i = 0;
+        while (i < n)
+        {
+            const size_t run = scan_bytes_string_builder(str + i, n - i, "\"", 1, 0, 0);
+            write_string_builder_ranged(builder, str + i, run);
+            i += run;
+
+            if (i < n)
+            {
+                // Double the quote
+                write_string_builder_ranged(builder, "\"\"", 2);
+                i++;
+            }
+        }
+
+        write_char_string_builder(builder, '"');
+        return;
+    }
+
+    // Reserve once, then write the quoted field
+    ensure_string_builder(builder, total);
+    char *dest = builder->buf + builder->idx;
+    *dest++ = '"';
+
+    i = 0;
+    while (i < n)
+    {
+        const size_t run = scan_bytes_string_builder(str + i, n - i, "\"", 1, 0, 0);
+        memcpy(dest, str + i, run);
+        dest += run;
+        i += run;
+
+        if (i < n)
+        {
+            // Double the quote
+            *dest++ = '"';
+            *dest++ = '"';
+            i++;
+        }
+    }
+
+    *dest++ = '"';
+    builder->idx = (size_t)(dest - builder->buf);
+}
+
+/**
+ * \brief Appends a whole CSV/TSV row terminated by CRLF.
+ *
+ * Writes every field with write_csv_field_string_builder, separated by \p separator.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param fields Fields of the row.
+ * \param count Number of fields.
+ * \param separator Field separator (e.g. ',' for CSV or '\\t' for TSV).
+ */
+static inline void write_csv_row_string_builder(
+    string_builder_t *builder,
+    const string_builder_slice_t *fields,
+    const size_t count,
+    const char separator
+)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i > 0)
+        {
+            write_char_string_builder(builder, separator);
+        }
+
+        write_csv_field_string_builder(builder, fields[i].ptr, fields[i].len, separator);
+    }
+
+    write_string_builder_ranged(builder, "\r\n", 2);
+}
+
+/**
+ * \enum string_builder_url_mode_t
+ * \brief Sets of characters that URL encoding leaves as they are.
+ */
+typedef enum
+{
+    STRING_BUILDER_URL_COMPONENT = 0x1, /**< RFC 3986 unreserved characters only (A-Z a-z 0-9 - . _ ~). */
+    STRING_BUILDER_URL_PATH = 0x2, /**< Unreserved, sub-delims, ':', '@' and '/' (RFC 3986 path). */
+    STRING_BUILDER_URL_QUERY = 0x4, /**< Like the path set plus '?', but escaping '&', '=' and '+'. */
+    STRING_BUILDER_URL_FORM = 0x8 /**< application/x-www-form-urlencoded: A-Z a-z 0-9 * - . _, space as '+'. */
+} string_builder_url_mode_t;
+
+/**
+ * \brief Classification of every byte: bit m is set if the byte is safe in URL mode m.
+ */
+static const unsigned char string_builder_url_safe[256] = {
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x6, 0x0, 0x0, 0x6, 0x0, 0x2, 0x6, 0x6, 0x6, 0xE, 0x2, 0x6, 0xF, 0xF, 0x6,
+    0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0x6, 0x6, 0x0, 0x2, 0x0, 0x4,
+    0x6, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF,
+    0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0x0, 0x0, 0x0, 0x0, 0xF,
+    0x0, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF,
+    0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0xF, 0x0, 0x0, 0x0, 0x7, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0
+};
+
+/**
+ * \brief Appends a string with URL percent-encoding applied.
+ *
+ * Bytes outside the safe set of \p mode are written as %XX (uppercase hex).
+ * The input is processed in blocks of STRING_BUILDER_ESCAPE_BLOCK bytes (smaller
+ * for streaming builders): the worst-case size of a block is reserved once, runs of safe bytes are found with
+ * the classification table and copied in bulk.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the source bytes (not necessarily null-terminated).
+ * \param n Number of bytes to encode.
+ * \param mode Which characters to leave unencoded.
+ */
+static inline void write_url_encoded_string_builder(
+    string_builder_t *builder,
+    const char *str,
+    const size_t n,
+    const string_builder_url_mode_t mode
+)
+{
+    const unsigned char *src = (const unsigned char *)str;
+    size_t offset = 0;
+
+    while (offset < n)
+    {
+        const size_t block_size = escape_block_string_builder(builder, 3);
+        const size_t block_end = n - offset < block_size ? n : offset + block_size;
+
+        // Every byte takes at most three characters
+        ensure_string_builder(builder, (block_end - offset) * 3);
+        char *dest = builder->buf + builder->idx;
+
+        while (offset < block_end)
+        {
+            // Copy the safe run in bulk
+            const size_t start = offset;
+            while (offset < block_end && (string_builder_url_safe[src[offset]] & mode))
+            {
+                offset++;
+            }
+
+            memcpy(dest, src + start, offset - start);
+            dest += offset - start;
+
+            if (offset == block_end)
+            {
+                break;
+            }
+
+            // Encode the byte
+            const unsigned char c = src[offset++];
+            if (c == ' ' && mode == STRING_BUILDER_URL_FORM)
+            {
+                *dest++ = '+';
+                continue;
+            }
+
+            dest[0] = '%';
+            dest[1] = string_builder_hex_digits[1][c >> 4];
+            dest[2] = string_builder_hex_digits[1][c & 0xF];
+            dest += 3;
+        }
+
+        builder->idx = (size_t)(dest - builder->buf);
+    }
+}
+
+/**
+ * \brief Appends a percent-encoded string with its escapes decoded.
+ *
+ * Decodes %XX sequences (either case) and, in STRING_BUILDER_URL_FORM mode,
+ * turns '+' into a space. Runs without escapes are copied in bulk.
+ * If the input contains a malformed escape, nothing is appended and -1 is
+ * returned: streaming builders check every escape before writing, as drained
+ * output cannot be taken back, and other builders are truncated back to their
+ * original length.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the encoded string (not necessarily null-terminated).
+ * \param n Number of characters to decode.
+ * \param mode Encoding mode the input was produced with.
+ * \return 0 on success, -1 if \p str contains a malformed escape.
+ */
+static inline int write_url_decoded_string_builder(
+    string_builder_t *builder,
+    const char *str,
+    const size_t n,
+    const string_builder_url_mode_t mode
+)
+{
+    const size_t needle_count = mode == STRING_BUILDER_URL_FORM ? 2 : 1;
+    size_t i = 0;
+
+    if (builder->sink != NULL)
+    {
+        // Validate up front, drained output cannot be rolled back
+        while (i < n)
+        {
+            i += scan_bytes_string_builder(str + i, n - i, "%", 1, 0, 0);
+            if (i == n)
+            {
+                break;
+            }
+
+            if (n - i <= 2 || hex_value_string_builder(str[i + 1]) < 0 || hex_value_string_builder(str[i + 2]) < 0)
+            {
+                return -1;
+            }
+
+            i += 3;
+        }
+
+        i = 0;
+    }
+
+    const size_t start = builder->idx;
+    while (i < n)
+    {
+        // Copy the run up to the next escape in bulk
+        const size_t run = scan_bytes_string_builder(str + i, n - i, "%+", needle_count, 0, 0);
+        if (run > 0)
+        {
+            write_string_builder_ranged(builder, str + i, run);
+            i += run;
+        }
+
+        if (i == n)
+        {
+            break;
+        }
+
+        if (str[i] == '+')
+        {
+            write_char_string_builder(builder, ' ');
+            i++;
+            continue;
+        }
+
+        // Decode %XX
+        const int high = n - i > 2 ? hex_value_string_builder(str[i + 1]) : -1;
+        const int low = n - i > 2 ? hex_value_string_builder(str[i + 2]) : -1;
+        if (high < 0 || low < 0)
+        {
+            truncate_string_builder(builder, start);
+            return -1;
+        }
+
+        write_char_string_builder(builder, (char)((high << 4) | low));
+        i += 3;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Base64 alphabets: RFC 4648 standard and URL-safe.
+ */
+static const char string_builder_base64_digits[2][65] = {
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+};
+
+/**
+ * \brief Values of base64 digits, 0xFF for other bytes.
+ *
+ * '+' and '/' carry 0x40 and '-' and '_' carry 0x80 on top of their value,
+ * so a decoder rejects the digits of the other alphabet with a single mask.
+ */
+static const unsigned char string_builder_base64_values[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7E, 0xFF, 0xBE, 0xFF, 0x7F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xBF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/**
+ * \brief Values of hexadecimal digits, 0xFF for other bytes.
+ */
+static const unsigned char string_builder_hex_values[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/**
+ * \brief Encodes bytes as base64 into a destination buffer.
+ *
+ * Encodes 12 bytes into 16 characters at a time with SSSE3 when available
+ * (the 6-bit fields are split with multiplies and mapped to the alphabet with
+ * a shuffle-based lookup), and 3 bytes at a time otherwise.
+ * The last group is padded with '=' if \p pad is nonzero.
+ *
+ * \param dest Destination with room for the encoded output.
+ * \param data Pointer to the bytes to encode.
+ * \param n Number of bytes to encode.
+ * \param url Whether to use the URL-safe alphabet.
+ * \param pad Whether to pad the last group.
+ * \return Pointer past the last character written.
+ */
+static inline char *encode_base64_string_builder(
+    char *dest,
+    const unsigned char *data,
+    const size_t n,
+    const int url,
+    const int pad
+)
+{
+    const char *table = string_builder_base64_digits[url ? 1 : 0];
+    size_t i = 0;
+
+#   ifdef STRING_BUILDER_SSSE3
+    // Offsets from the 6-bit values to the alphabet, indexed by range
+    const __m128i offsets = url
+        ? _mm_setr_epi8(71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 65, 0, 0)
+        : _mm_setr_epi8(71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 65, 0, 0);
+
+    // Loads 16 bytes, of which 12 are encoded
+    for (; i + 16 <= n; i += 12)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i *)(data + i));
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+        // Move each 6-bit field into its own byte
+        const __m128i high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        const __m128i low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        const __m128i values = _mm_or_si128(high, low);
+
+        // 0-25 map to range 13, 26-51 to 0, 52-61 to 1-10, 62 to 11 and 63 to 12
+        __m128i range = _mm_subs_epu8(values, _mm_set1_epi8(51));
+        range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), values), _mm_set1_epi8(13)));
+
+        _mm_storeu_si128((__m128i *)dest, _mm_add_epi8(values, _mm_shuffle_epi8(offsets, range)));
+        dest += 16;
+    }
+#   endif
+
+    for (; i + 3 <= n; i += 3)
+    {
+        const uint32_t group = (uint32_t)data[i] << 16 | (uint32_t)data[i + 1] << 8 | data[i + 2];
+        dest[0] = table[group >> 18];
+        dest[1] = table[(group >> 12) & 0x3F];
+        dest[2] = table[(group >> 6) & 0x3F];
+        dest[3] = table[group & 0x3F];
+        dest += 4;
+    }
+
+    // Encode the last partial group
+    if (i < n)
+    {
+        const uint32_t group = (uint32_t)data[i] << 16 | (i + 1 < n ? (uint32_t)data[i + 1] << 8 : 0);
+        *dest++ = table[group >> 18];
+        *dest++ = table[(group >> 12) & 0x3F];
+        if (i + 1 < n)
+        {
+            *dest++ = table[(group >> 6) & 0x3F];
+        }
+        else if (pad)
+        {
+            *dest++ = '=';
+        }
+
+        if (pad)
+        {
+            *dest++ = '=';
+        }
+    }
+
+    return dest;
+}
+
+/**
+ * \brief Appends bytes encoded as base64.
+ *
+ * The exact size of the output is reserved up front, then the input is encoded
+ * in blocks straight into the buffer (streaming builders drain between blocks).
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param data Pointer to the bytes to encode.
+ * \param n Number of bytes to encode.
+ * \param url Whether to use the URL-safe alphabet.
+ * \param pad Whether to pad the output with '='.
+ */
+static inline void write_base64_encoded_string_builder(
+    string_builder_t *builder,
+    const void *data,
+    const size_t n,
+    const int url,
+    const int pad
+)
+{
+    const unsigned char *src = (const unsigned char *)data;
+
+    // Reserve the whole output at once unless it is streamed
+    const size_t tail = n % 3;
+    const size_t encoded_len = add_size_string_builder(mul_size_string_builder(n / 3, 4), tail == 0 ? 0 : pad ? 4 : tail + 1);
+    if (builder->sink == NULL)
+    {
+        reserve_additional_string_builder(builder, encoded_len);
+    }
+
+    size_t offset = 0;
+    while (offset < n)
+    {
+        // Blocks are a multiple of 3 bytes so only the last one has a partial group
+        const size_t block_size = escape_block_string_builder(builder, 4) * 3;
+        const size_t block_len = n - offset < block_size ? n - offset : block_size;
+
+        ensure_string_builder(builder, (block_len + 2) / 3 * 4);
+        char *dest = encode_base64_string_builder(builder->buf + builder->idx, src + offset, block_len, url, pad);
+        builder->idx = (size_t)(dest - builder->buf);
+        offset += block_len;
+    }
+}
+
+/**
+ * \brief Appends bytes encoded as padded standard base64 (RFC 4648, section 4).
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param data Pointer to the bytes to encode.
+ * \param n Number of bytes to encode.
+ */
+static inline void write_base64_string_builder(string_builder_t *builder, const void *data, const size_t n)
+{
+    write_base64_encoded_string_builder(builder, data, n, 0, 1);
+}
+
+/**
+ * \brief Appends bytes encoded as unpadded base64url (RFC 4648, section 5).
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param data Pointer to the bytes to encode.
+ * \param n Number of bytes to encode.
+ */
+static inline void write_base64url_string_builder(string_builder_t *builder, const void *data, const size_t n)
+{
+    write_base64_encoded_string_builder(builder, data, n, 1, 0);
+}
+
+/**
+ * \brief Appends the bytes encoded by a base64 string.
+ *
+ * Trailing '=' padding is optional. Four characters are decoded at a time through
+ * a lookup table, straight into the buffer, in blocks like the encoders; the digits
+ * of the other alphabet are rejected. If the input is malformed, nothing is appended
+ * and -1 is returned: streaming builders validate the whole input first, as drained
+ * output cannot be taken back, and other builders truncate what was decoded.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the encoded string (not necessarily null-terminated).
+ * \param n Number of characters to decode.
+ * \param url Whether \p str uses the URL-safe alphabet.
+ * \return 0 on success, -1 if \p str is not valid base64.
+ */
+static inline int write_base64_decoded_string_builder(
+    string_builder_t *builder,
+    const char *str,
+    size_t n,
+    const int url
+)
+{
+    const unsigned char *src = (const unsigned char *)str;
+    const unsigned char reject = url ? 0x40 : 0x80;
+
+    // Strip the padding
+    if (n > 0 && n % 4 == 0 && src[n - 1] == '=')
+    {
+        n -= src[n - 2] == '=' ? 2 : 1;
+    }
+
+    const size_t tail = n % 4;
+    if (tail == 1)
+    {
+        return -1;
+    }
+
+    if (builder->sink != NULL)
+    {
+        // Validate up front, drained output cannot be rolled back
+        unsigned char values = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            values |= string_builder_base64_values[src[i]];
+        }
+
+        if (values & reject)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        // Reserve the whole output at once
+        reserve_additional_string_builder(builder, n / 4 * 3 + (tail == 0 ? 0 : tail - 1));
+    }
+
+    const size_t start = builder->idx;
+    const size_t groups = n / 4;
+    size_t group = 0;
+
+    while (group < groups)
+    {
+        const size_t block_size = escape_block_string_builder(builder, 3);
+        const size_t block_end = groups - group < block_size ? groups : group + block_size;
+
+        ensure_string_builder(builder, (block_end - group) * 3);
+        char *dest = builder->buf + builder->idx;
+
+        for (; group < block_end; group++)
+        {
+            const unsigned char *in = src + group * 4;
+            const unsigned char a = string_builder_base64_values[in[0]];
+            const unsigned char b = string_builder_base64_values[in[1]];
+            const unsigned char c = string_builder_base64_values[in[2]];
+            const unsigned char d = string_builder_base64_values[in[3]];
+            if ((a | b | c | d) & reject)
+            {
+                truncate_string_builder(builder, start);
+                return -1;
+            }
+
+            const uint32_t value = (uint32_t)(a & 0x3F) << 18 | (uint32_t)(b & 0x3F) << 12 | (uint32_t)(c & 0x3F) << 6 | (d & 0x3F);
+            dest[0] = (char)(value >> 16);
+            dest[1] = (char)(value >> 8);
+            dest[2] = (char)value;
+            dest += 3;
+        }
+
+        builder->idx = (size_t)(dest - builder->buf);
+    }
+
+    // Decode the last partial group
+    if (tail != 0)
+    {
+        const unsigned char *in = src + groups * 4;
+        const unsigned char a = string_builder_base64_values[in[0]];
+        const unsigned char b = string_builder_base64_values[in[1]];
+        const unsigned char c = tail == 3 ? string_builder_base64_values[in[2]] : 0;
+        if ((a | b | c) & reject)
+        {
+            truncate_string_builder(builder, start);
+            return -1;
+        }
+
+        const uint32_t value = (uint32_t)(a & 0x3F) << 18 | (uint32_t)(b & 0x3F) << 12 | (uint32_t)(c & 0x3F) << 6;
+        write_char_string_builder(builder, (char)(value >> 16));
+        if (tail == 3)
+        {
+            write_char_string_builder(builder, (char)(value >> 8));
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Encodes bytes as hexadecimal into a destination buffer.
+ *
+ * Encodes 16 bytes at a time with SSSE3 when available, looking up both
+ * nibbles with a shuffle and interleaving them, and one byte at a time otherwise.
+ *
+ * \param dest Destination with room for 2 * \p n characters.
+ * \param data Pointer to the bytes to encode.
+ * \param n Number of bytes to encode.
+ * \param uppercase Whether to use uppercase digits.
+ * \return Pointer past the last character written.
+ */
+static inline char *encode_hex_string_builder(
+    char *dest,
+    const unsigned char *data,
+    const size_t n,
+    const int uppercase
+)
+{
+    const char *table = string_builder_hex_digits[uppercase ? 1 : 0];
+    size_t i = 0;
+
+#   ifdef STRING_BUILDER_SSSE3
+    const __m128i digits = _mm_loadu_si128((const __m128i *)table);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i in = _mm_loadu_si128((const __m128i *)(data + i));
+        const __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+        const __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(in, nibble));
+        _mm_storeu_si128((__m128i *)dest, _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i *)(dest + 16), _mm_unpackhi_epi8(high, low));
+        dest += 32;
+    }
+#   endif
+
+    for (; i < n; i++)
+    {
+        dest[0] = table[data[i] >> 4];
+        dest[1] = table[data[i] & 0xF];
+        dest += 2;
+    }
+
+    return dest;
+}
+
+/**
+ * \brief Appends bytes encoded as hexadecimal, two digits per byte.
+ *
+ * The exact size of the output is reserved up front, then the input is encoded
+ * in blocks straight into the buffer (streaming builders drain between blocks).
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param data Pointer to the bytes to encode.
+ * \param n Number of bytes to encode.
+ * \param uppercase Whether to use uppercase digits.
+ */
+static inline void write_hex_string_builder(
+    string_builder_t *builder,
+    const void *data,
+    const size_t n,
+    const int uppercase
+)
+{
+    const unsigned char *src = (const unsigned char *)data;
+
+    // Reserve the whole output at once unless it is streamed
+    if (builder->sink == NULL)
+    {
+        reserve_additional_string_builder(builder, mul_size_string_builder(n, 2));
+    }
+
+    size_t offset = 0;
+    while (offset < n)
+    {
+        const size_t block_size = escape_block_string_builder(builder, 2);
+        const size_t block_len = n - offset < block_size ? n - offset : block_size;
+
+        ensure_string_builder(builder, block_len * 2);
+        char *dest = encode_hex_string_builder(builder->buf + builder->idx, src + offset, block_len, uppercase);
+        builder->idx = (size_t)(dest - builder->buf);
+        offset += block_len;
+    }
+}
+
+/**
+ * \brief Appends the bytes encoded by a hexadecimal string.
+ *
+ * Accepts digits of either case, two per byte, decoded through a lookup table
+ * straight into the buffer, in blocks like the encoder. If the input is malformed,
+ * nothing is appended and -1 is returned: streaming builders validate the whole
+ * input first, as drained output cannot be taken back, and other builders
+ * truncate what was decoded.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the encoded string (not necessarily null-terminated).
+ * \param n Number of characters to decode.
+ * \return 0 on success, -1 if \p str has an odd length or a non-hexadecimal character.
+ */
+static inline int write_hex_decoded_string_builder(string_builder_t *builder, const char *str, const size_t n)
+{
+    const unsigned char *src = (const unsigned char *)str;
+    if (n % 2 != 0)
+    {
+        return -1;
+    }
+
+    if (builder->sink != NULL)
+    {
+        // Validate up front, drained output cannot be rolled back
+        unsigned char values = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            values |= string_builder_hex_values[src[i]];
+        }
+
+        if (values > 0xF)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        // Reserve the whole output at once
+        reserve_additional_string_builder(builder, n / 2);
+    }
+
+    const size_t start = builder->idx;
+    const size_t bytes = n / 2;
+    size_t i = 0;
+
+    while (i < bytes)
+    {
+        const size_t block_size = escape_block_string_builder(builder, 1);
+        const size_t block_end = bytes - i < block_size ? bytes : i + block_size;
+
+        ensure_string_builder(builder, block_end - i);
+        char *dest = builder->buf + builder->idx;
+
+        for (; i < block_end; i++)
+        {
+            const unsigned char high = string_builder_hex_values[src[i * 2]];
+            const unsigned char low = string_builder_hex_values[src[i * 2 + 1]];
+            if ((high | low) > 0xF)
+            {
+                truncate_string_builder(builder, start);
+                return -1;
+            }
+
+            *dest++ = (char)(high << 4 | low);
+        }
+
+        builder->idx = (size_t)(dest - builder->buf);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Appends a UTF-16 string transcoded to UTF-8.
+ *
+ * Code units are in native byte order. Surrogate pairs are combined and lone
+ * surrogates are written as U+FFFD. Runs of ASCII are narrowed 16 units at a
+ * time with SSE2 when available. The input is processed in blocks whose
+ * worst-case output is reserved once, and written straight into the buffer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the UTF-16 code units.
+ * \param n Number of code units to transcode.
+ */
+static inline void write_utf16_string_builder(string_builder_t *builder, const uint16_t *str, const size_t n)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        // Leave room for the unit a pair may borrow from the next block
+        const size_t block_size = escape_block_string_builder(builder, 3);
+        const size_t block_units = block_size > 1 ? block_size - 1 : 1;
+        const size_t block_end = n - i < block_units ? n : i + block_units;
+
+        // Every unit takes at most 3 bytes, plus one unit a pair may borrow from the next block
+        ensure_string_builder(builder, (block_end - i + 1) * 3);
+        char *dest = builder->buf + builder->idx;
+
+        while (i < block_end)
+        {
+#   ifdef STRING_BUILDER_SSE2
+            // Narrow ASCII runs
+            const __m128i non_ascii = _mm_set1_epi16((short)0xFF80);
+            while (i + 16 <= block_end)
+            {
+                const __m128i low = _mm_loadu_si128((const __m128i *)(str + i));
+                const __m128i high = _mm_loadu_si128((const __m128i *)(str + i + 8));
+                const __m128i check = _mm_and_si128(_mm_or_si128(low, high), non_ascii);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(check, _mm_setzero_si128())) != 0xFFFF)
+                {
+                    break;
+                }
+
+                _mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(low, high));
+                dest += 16;
+                i += 16;
+            }
+
+            if (i == block_end)
+            {
+                break;
+            }
+#   endif
+
+            const uint16_t unit = str[i++];
+            if (unit < 0x80)
+            {
+                *dest++ = (char)unit;
+                continue;
+            }
+
+            uint32_t codepoint = unit;
+            if (unit >= 0xD800 && unit <= 0xDBFF && i < n && str[i] >= 0xDC00 && str[i] <= 0xDFFF)
+            {
+                // Combine the surrogate pair
+                codepoint = 0x10000 + ((uint32_t)(unit - 0xD800) << 10) + (uint32_t)(str[i++] - 0xDC00);
+            }
+
+            dest += encode_utf8_string_builder(dest, codepoint);
+        }
+
+        builder->idx = (size_t)(dest - builder->buf);
+    }
+}
+
+/**
+ * \brief Appends a UTF-32 string transcoded to UTF-8.
+ *
+ * Code units are in native byte order. Surrogates and values above U+10FFFF
+ * are written as U+FFFD. Runs of ASCII are narrowed 16 units at a time with
+ * SSE2 when available. The input is processed in blocks whose worst-case
+ * output is reserved once, and written straight into the buffer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the UTF-32 code units.
+ * \param n Number of code units to transcode.
+ */
+static inline void write_utf32_string_builder(string_builder_t *builder, const uint32_t *str, const size_t n)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        const size_t block_size = escape_block_string_builder(builder, 4);
+        const size_t block_end = n - i < block_size ? n : i + block_size;
+
+        // Every unit takes at most 4 bytes
+        ensure_string_builder(builder, (block_end - i) * 4);
+        char *dest = builder->buf + builder->idx;
+
+        while (i < block_end)
+        {
+#   ifdef STRING_BUILDER_SSE2
+            // Narrow ASCII runs
+            const __m128i non_ascii = _mm_set1_epi32((int)0xFFFFFF80);
+            while (i + 16 <= block_end)
+            {
+                const __m128i a = _mm_loadu_si128((const __m128i *)(str + i));
+                const __m128i b = _mm_loadu_si128((const __m128i *)(str + i + 4));
+                const __m128i c = _mm_loadu_si128((const __m128i *)(str + i + 8));
+                const __m128i d = _mm_loadu_si128((const __m128i *)(str + i + 12));
+                const __m128i check = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), non_ascii);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(check, _mm_setzero_si128())) != 0xFFFF)
+                {
+                    break;
+                }
+
+                _mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+                dest += 16;
+                i += 16;
+            }
+
+            if (i == block_end)
+            {
+                break;
+            }
+#   endif
+
+            dest += encode_utf8_string_builder(dest, str[i++]);
+        }
+
+        builder->idx = (size_t)(dest - builder->buf);
+    }
+}
+
+/**
+ * \brief Appends several ranges of characters back to back.
+ *
+ * Sums the lengths first and reserves the total once, so the pieces are copied
+ * without a capacity check or reallocation per piece. Streaming builders fall
+ * back to appending the pieces one by one when they would not fit the buffer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param parts Ranges to append, in order.
+ * \param count Number of ranges in \p parts.
+ */
+static inline void write_many_string_builder(
+    string_builder_t *builder,
+    const string_builder_slice_t *parts,
+    const size_t count
+)
+{
+    // Compute the total length
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        total = add_size_string_builder(total, parts[i].len);
+    }
+
+    // Streaming builders keep their buffer size
+    if (exceeds_stream_buffer_string_builder(builder, total))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            write_string_builder_ranged(builder, parts[i].ptr, parts[i].len);
+        }
+
+        return;
+    }
+
+    // Reserve once and copy every part
+    ensure_string_builder(builder, total);
+    char *dest = builder->buf + builder->idx;
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(dest, parts[i].ptr, parts[i].len);
+        dest += parts[i].len;
+    }
+
+    builder->idx += total;
+
+    if (builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8)
+    {
+        sync_utf8_string_builder(builder);
+    }
+}
+
+/**
+ * \brief Appends strings separated by a separator.
+ *
+ * Computes the total size, separators included, and reserves it once, then copies
+ * the strings and separators back to back. Streaming builders fall back to
+ * appending the pieces one by one when they would not fit the buffer.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param strs Strings to join (not necessarily null-terminated).
+ * \param lens Length of every string in \p strs.
+ * \param count Number of strings.
+ * \param sep Separator written between two strings.
+ * \param sep_len Length of \p sep.
+ */
+static inline void join_string_builder(
+    string_builder_t *builder,
+    const char *const *strs,
+    const size_t *lens,
+    const size_t count,
+    const char *sep,
+    const size_t sep_len
+)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Compute the total length, separators included
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        total = add_size_string_builder(total, lens[i]);
+        if (i > 0)
+        {
+            total = add_size_string_builder(total, sep_len);
+        }
+    }
+
+    // Streaming builders keep their buffer size
+    if (exceeds_stream_buffer_string_builder(builder, total))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i > 0)
+            {
+                write_string_builder_ranged(builder, sep, sep_len);
+            }
+
+            write_string_builder_ranged(builder, strs[i], lens[i]);
+        }
+
+        return;
+    }
+
+    // Reserve once and copy every string and separator
+    ensure_string_builder(builder, total);
+    char *dest = builder->buf + builder->idx;
+    memcpy(dest, strs[0], lens[0]);
+    dest += lens[0];
+    for (size_t i = 1; i < count; i++)
+    {
+        memcpy(dest, sep, sep_len);
+        memcpy(dest + sep_len, strs[i], lens[i]);
+        dest += sep_len + lens[i];
+    }
+
+    builder->idx += total;
+
+    if (builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8)
+    {
+        sync_utf8_string_builder(builder);
+    }
+}
+
+/**
+ * \brief Appends the strings of a NULL-terminated array separated by a separator.
+ *
+ * The strings are measured STRING_BUILDER_JOIN_BATCH at a time and every batch
+ * is joined with join_string_builder, so each string is scanned by strlen once
+ * and the output is reserved once per batch.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param strs Null-terminated strings to join, followed by a NULL pointer.
+ * \param sep Null-terminated separator written between two strings.
+ */
+static inline void join_null_terminated_string_builder(
+    string_builder_t *builder,
+    const char *const *strs,
+    const char *sep
+)
+{
+    const size_t sep_len = strlen(sep);
+    size_t lens[STRING_BUILDER_JOIN_BATCH];
+
+    for (size_t i = 0; strs[i] != NULL;)
+    {
+        // Measure the next batch
+        size_t count = 0;
+        while (count < STRING_BUILDER_JOIN_BATCH && strs[i + count] != NULL)
+        {
+            lens[count] = strlen(strs[i + count]);
+            count++;
+        }
+
+        if (i > 0)
+        {
+            write_string_builder_ranged(builder, sep, sep_len);
+        }
+
+        join_string_builder(builder, strs + i, lens, count, sep, sep_len);
+        i += count;
+    }
+}
+
+/**
+ * \brief Appends a character repeated \p n times.
+ *
+ * Reserves the whole run once and fills it with memset. Streaming builders
+ * fill and drain their buffer one bufferful at a time.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param c Character to repeat.
+ * \param n Number of times to write \p c.
+ */
+static inline void write_repeat_string_builder(string_builder_t *builder, const char c, size_t n)
+{
+    while (n > 0)
+    {
+        // Streaming builders keep their buffer size
+        const size_t chunk = exceeds_stream_buffer_string_builder(builder, n) && builder->capacity > 0 ? builder->capacity : n;
+
+        ensure_string_builder(builder, chunk);
+        memset(builder->buf + builder->idx, c, chunk);
+        builder->idx += chunk;
+        n -= chunk;
+    }
+
+    if (builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8)
+    {
+        sync_utf8_string_builder(builder);
+    }
+}
+
+/**
+ * \brief Appends a string repeated \p n times.
+ *
+ * Reserves the whole output once, copies the pattern once and then keeps
+ * doubling the copied region, so only O(log n) memcpy calls are made.
+ * Streaming builders do the same one bufferful of repetitions at a time.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pattern to repeat (not necessarily null-terminated).
+ * \param len Length of \p str.
+ * \param n Number of times to write \p str.
+ */
+static inline void write_repeat_str_string_builder(
+    string_builder_t *builder,
+    const char *str,
+    const size_t len,
+    size_t n
+)
+{
+    if (len == 0)
+    {
+        return;
+    }
+
+    // Make sure the total size does not overflow
+    mul_size_string_builder(n, len);
+
+    // Streaming builders that cannot hold a single copy pass every copy through
+    if (exceeds_stream_buffer_string_builder(builder, len))
+    {
+        for (; n > 0; n--)
+        {
+            write_string_builder_ranged(builder, str, len);
+        }
+
+        return;
+    }
+
+    while (n > 0)
+    {
+        // Streaming builders write one bufferful of repetitions at a time
+        const size_t reps = exceeds_stream_buffer_string_builder(builder, n * len) ? builder->capacity / len : n;
+        const size_t total = reps * len;
+
+        ensure_string_builder(builder, total);
+        char *dest = builder->buf + builder->idx;
+
+        // Copy the pattern once, then double the copied region
+        memcpy(dest, str, len);
+        size_t done = len;
+        while (done < total)
+        {
+            const size_t copy = done < total - done ? done : total - done;
+            memcpy(dest + done, dest, copy);
+            done += copy;
+        }
+
+        builder->idx += total;
+        n -= reps;
+    }
+
+    if (builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8)
+    {
+        sync_utf8_string_builder(builder);
+    }
+}
+
+/**
+ * \enum string_builder_align_t
+ * \brief Placement of a string inside a padded field.
+ */
+typedef enum
+{
+    STRING_BUILDER_ALIGN_LEFT, /**< Padding after the string. */
+    STRING_BUILDER_ALIGN_RIGHT, /**< Padding before the string. */
+    STRING_BUILDER_ALIGN_CENTER /**< Padding split around the string, the extra character after it. */
+} string_builder_align_t;
+
+/**
+ * \brief Counts the UTF-8 code points of a string.
+ *
+ * Counts every byte that is not a continuation byte, 8 bytes at a time.
+ * Invalid sequences count one code point per lead or stray byte.
+ *
+ * \param str Pointer to the string (not necessarily null-terminated).
+ * \param len Length of \p str in bytes.
+ * \return Number of code points in \p str.
+ */
+static inline size_t count_codepoints_string_builder(const char *str, const size_t len)
+{
+    size_t count = len;
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, str + i, 8);
+
+        // Continuation bytes have the top bits 10
+        const uint64_t continuation = (word & ~(word << 1)) & 0x8080808080808080ull;
+        count -= (size_t)(((continuation >> 7) * 0x0101010101010101ull) >> 56);
+    }
+
+    for (; i < len; i++)
+    {
+        if (((unsigned char)str[i] & 0xC0) == 0x80)
+        {
+            count--;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * \brief Appends a string padded to a field of a given display width.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the string (not necessarily null-terminated).
+ * \param len Length of \p str in bytes.
+ * \param str_width Display width of \p str.
+ * \param width Width of the field.
+ * \param align Placement of \p str in the field.
+ * \param fill Character used for padding.
+ */
+static inline void write_field_string_builder(
+    string_builder_t *builder,
+    const char *str,
+    const size_t len,
+    const size_t str_width,
+    const size_t width,
+    const string_builder_align_t align,
+    const char fill
+)
+{
+    const size_t pad = width > str_width ? width - str_width : 0;
+    const size_t before = align == STRING_BUILDER_ALIGN_RIGHT ? pad : align == STRING_BUILDER_ALIGN_CENTER ? pad / 2 : 0;
+    const size_t after = pad - before;
+
+    // Make sure the total size does not overflow
+    const size_t total = add_size_string_builder(len, pad);
+
+    // Streaming builders keep their buffer size
+    if (exceeds_stream_buffer_string_builder(builder, total))
+    {
+        write_repeat_string_builder(builder, fill, before);
+        write_string_builder_ranged(builder, str, len);
+        write_repeat_string_builder(builder, fill, after);
+        return;
+    }
+
+    // Reserve once, pad with memset
+    ensure_string_builder(builder, total);
+    char *dest = builder->buf + builder->idx;
+    memset(dest, fill, before);
+    memcpy(dest + before, str, len);
+    memset(dest + before + len, fill, after);
+    builder->idx += total;
+
+    if (builder->flags & STRING_BUILDER_FLAG_VALIDATE_UTF8)
+    {
+        sync_utf8_string_builder(builder);
+    }
+}
+
+/**
+ * \brief Appends a string padded to at least \p width characters.
+ *
+ * Reserves max(len, width) characters once and writes the padding with memset.
+ * Strings longer than \p width are written as they are.
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the string (not necessarily null-terminated).
+ * \param len Length of \p str.
+ * \param width Minimum number of characters to write.
+ * \param align Placement of \p str in the field.
+ * \param fill Character used for padding.
+ */
+static inline void write_padded_string_builder(
+    string_builder_t *builder,
+    const char *str,
+    const size_t len,
+    const size_t width,
+    const string_builder_align_t align,
+    const char fill
+)
+{
+    write_field_string_builder(builder, str, len, len, width, align, fill);
+}
+
+/**
+ * \brief Appends a UTF-8 string padded to at least \p width code points.
+ *
+ * Like write_padded_string_builder, but the width of \p str is its number of
+ * code points, so fields with non-ASCII text line up in a terminal (as long as
+ * every code point takes one column).
+ *
+ * \param builder Pointer to the string_builder_t.
+ * \param str Pointer to the UTF-8 string (not necessarily null-terminated).
+ * \param len Length of \p str in bytes.
+ * \param width Minimum number of code points to write.
+ * \param align Placement of \p str in the field.
+ * \param fill Character used for padding.
+ */
+static inline void write_padded_utf8_string_builder(
+    string_builder_t *builder,
+    const char *str,
+    const size_t len,
+    const size_t width,
+    const string_builder_align_t align,
+    const char fill
+)
+{
+    write_field_string_builder(builder, str, len, count_codepoints_string_builder(str, len), width, align, fill);
+}
+
+/**
+ * \struct string_builder_emitter_t
+ * \brief A code emitter that writes indented lines to a string builder.
+ *
+ * Text written through the emitter is indented lazily: the indent of a line is
+ * only written before its first character, so blank lines stay empty. The
+ * emitter tracks the current line and column as the text goes by, which is
+ * what #line directives need. Text written to the builder directly is not tracked.
+ */
+typedef struct
+{
+    string_builder_t *builder; /**< Builder that receives the output. */
+    size_t indent_level; /**< Current indentation level. */
+    size_t indent_width; /**< Number of indent characters per level. */
+    size_t line; /**< Current line, starting at 1. */
+    size_t column; /**< Number of characters written on the current line, indent included. */
+    char indent[STRING_BUILDER_INDENT_CAPACITY]; /**< Indent characters, copied at the start of every line. */
+} string_builder_emitter_t;
+
+/**
+ * \brief Initializes a string_builder_emitter_t on top of a builder.
+ *
+ * The output is assumed to start at line 1, column 0. The builder must outlive the emitter.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t to initialize.
+ * \param builder Builder that receives the output.
+ * \param indent_char Character used for indentation (e.g. ' ' or '\t').
+ * \param indent_width Number of \p indent_char per indentation level.
+ */
+static inline void init_string_builder_emitter(
+    string_builder_emitter_t *emitter,
+    string_builder_t *builder,
+    const char indent_char,
+    const size_t indent_width
+)
+{
+    emitter->builder = builder;
+    emitter->indent_level = 0;
+    emitter->indent_width = indent_width;
+    emitter->line = 1;
+    emitter->column = 0;
+    memset(emitter->indent, indent_char, sizeof(emitter->indent));
+}
+
+/**
+ * \brief Increases the indentation level of the following lines.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t.
+ */
+static inline void indent_string_builder_emitter(string_builder_emitter_t *emitter)
+{
+    emitter->indent_level++;
+}
+
+/**
+ * \brief Decreases the indentation level of the following lines.
+ *
+ * Does nothing if the level is already 0.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t.
+ */
+static inline void dedent_string_builder_emitter(string_builder_emitter_t *emitter)
+{
+    if (emitter->indent_level > 0)
+    {
+        emitter->indent_level--;
+    }
+}
+
+/**
+ * \brief Writes the indent of the current line.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t.
+ */
+static inline void write_indent_string_builder_emitter(string_builder_emitter_t *emitter)
+{
+    size_t remaining = emitter->indent_level * emitter->indent_width;
+    emitter->column += remaining;
+
+    // Copy from the pre-filled indent buffer
+    while (remaining > 0)
+    {
+        const size_t chunk = remaining < STRING_BUILDER_INDENT_CAPACITY ? remaining : STRING_BUILDER_INDENT_CAPACITY;
+        write_string_builder_ranged(emitter->builder, emitter->indent, chunk);
+        remaining -= chunk;
+    }
+}
+
+/**
+ * \brief Writes text through the emitter.
+ *
+ * The text may span several lines: each non-empty line is indented before its
+ * first character, and the line and column are updated from the newlines found
+ * with a single memchr pass.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t.
+ * \param str Pointer to the text (not necessarily null-terminated).
+ * \param n Number of characters to write.
+ */
+static inline void write_string_builder_emitter(string_builder_emitter_t *emitter, const char *str, const size_t n)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        const char *newline = (const char *)memchr(str + i, '\n', n - i);
+        const size_t end = newline == NULL ? n : (size_t)(newline - str);
+
+        // Indent the line lazily, before its first character
+        if (end > i)
+        {
+            if (emitter->column == 0)
+            {
+                write_indent_string_builder_emitter(emitter);
+            }
+
+            write_string_builder_ranged(emitter->builder, str + i, end - i);
+            emitter->column += end - i;
+        }
+
+        if (newline == NULL)
+        {
+            break;
+        }
+
+        write_char_string_builder(emitter->builder, '\n');
+        emitter->line++;
+        emitter->column = 0;
+        i = end + 1;
+    }
+}
+
+/**
+ * \brief Writes a null-terminated string through the emitter.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t.
+ * \param str Null-terminated text to write.
+ */
+static inline void write_cstr_string_builder_emitter(string_builder_emitter_t *emitter, const char *str)
+{
+    write_string_builder_emitter(emitter, str, strlen(str));
+}
+
+/**
+ * \brief Ends the current line.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t.
+ */
+static inline void newline_string_builder_emitter(string_builder_emitter_t *emitter)
+{
+    write_char_string_builder(emitter->builder, '\n');
+    emitter->line++;
+    emitter->column = 0;
+}
+
+/**
+ * \brief Writes a whole line of text, followed by a newline.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t.
+ * \param str Pointer to the text (not necessarily null-terminated).
+ * \param n Number of characters to write.
+ */
+static inline void write_line_string_builder_emitter(string_builder_emitter_t *emitter, const char *str, const size_t n)
+{
+    write_string_builder_emitter(emitter, str, n);
+    newline_string_builder_emitter(emitter);
+}
+
+/**
+ * \brief Writes a #line directive on a line of its own.
+ *
+ * Ends the current line first if it is not empty. The directive is never indented.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t.
+ * \param line Line number of the line that follows the directive.
+ * \param file Null-terminated file name, or NULL to keep the current one.
+ */
+static inline void write_line_directive_string_builder_emitter(
+    string_builder_emitter_t *emitter,
+    const size_t line,
+    const char *file
+)
+{
+    if (emitter->column != 0)
+    {
+        newline_string_builder_emitter(emitter);
+    }
+
+    write_string_builder_ranged(emitter->builder, "#line ", 6);
+    write_u64_string_builder(emitter->builder, (uint64_t)line);
+    if (file != NULL)
+    {
+        write_string_builder_ranged(emitter->builder, " \"", 2);
+        write_c_escaped_string_builder(emitter->builder, file, strlen(file));
+        write_char_string_builder(emitter->builder, '"');
+    }
+
+    newline_string_builder_emitter(emitter);
+}
+
+/**
+ * \brief Writes a #line directive that switches back to the numbering of the output itself.
+ *
+ * Used after a region mapped to another file, so that diagnostics point into
+ * the generated file again. The line number is taken from the emitter.
+ *
+ * \param emitter Pointer to the string_builder_emitter_t.
+ * \param file Null-terminated name of the generated file.
+ */
+static inline void write_own_line_directive_string_builder_emitter(string_builder_emitter_t *emitter, const char *file)
+{
+    if (emitter->column != 0)
+    {
+        newline_string_builder_emitter(emitter);
+    }
+
+    // The directive takes the current line, the next one keeps its own number
+    write_line_directive_string_builder_emitter(emitter, emitter->line + 1, file);
 }
 
 #if defined(__cplusplus)
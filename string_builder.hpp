@@ -0,0 +1,374 @@
+/*
+    The Fluent Programming Language
+    -----------------------------------------------------
+    This code is released under the GNU GPL v3 license.
+    For more information, please visit:
+    https://www.gnu.org/licenses/gpl-3.0.html
+    -----------------------------------------------------
+    Copyright (c) 2025 Rodrigo R. & All Fluent Contributors
+    This program comes with ABSOLUTELY NO WARRANTY.
+    For details type `fluent l`. This is free software,
+    and you are welcome to redistribute it under certain
+    conditions; type `fluent l -f` for details.
+*/
+
+#ifndef FLUENT_LIBC_STRING_BUILDER_HPP
+#define FLUENT_LIBC_STRING_BUILDER_HPP
+
+#if __cplusplus < 202002L
+#   error "string_builder.hpp requires C++20"
+#endif
+
+#include "string_builder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace fluent
+{
+    /**
+     * \brief Maximum number of operations a format string can be parsed into.
+     */
+    inline constexpr std::size_t string_builder_max_format_ops = 64;
+
+    /**
+     * \struct string_builder_format_op_t
+     * \brief A literal run of the format string, optionally followed by an argument.
+     */
+    struct string_builder_format_op_t
+    {
+        std::size_t offset = 0; /**< Offset of the literal run in the format string. */
+        std::size_t len = 0; /**< Length of the literal run. */
+        bool has_arg = false; /**< Whether the next argument follows the run. */
+        char spec = '\0'; /**< Presentation of the argument: '\0', 'x', 'X', 'o' or 'b'. */
+    };
+
+    /**
+     * \brief Reports a malformed format string.
+     *
+     * Deliberately not constexpr: reaching it while parsing a format string
+     * turns the mistake into a compile-time error that names this function.
+     *
+     * \param message Description of the problem.
+     */
+    inline void string_builder_format_error(const char *message)
+    {
+        (void)message;
+    }
+
+    /**
+     * \brief Whether values of type T are appended as strings.
+     */
+    template <typename T>
+    inline constexpr bool is_string_builder_string_v =
+        std::is_convertible_v<const T &, std::string_view> || std::is_convertible_v<const T &, const char *>;
+
+    /**
+     * \brief Whether type T can be appended with the given presentation.
+     *
+     * \param spec Presentation character ('\0' for the default one).
+     */
+    template <typename T>
+    constexpr bool accepts_string_builder_spec(const char spec)
+    {
+        using U = std::remove_cvref_t<T>;
+        if (spec == '\0')
+        {
+            return std::is_arithmetic_v<U> || is_string_builder_string_v<U>;
+        }
+
+        return std::is_integral_v<U> && !std::is_same_v<U, bool>;
+    }
+
+    /**
+     * \class format_string
+     * \brief A format string checked and parsed at compile time.
+     *
+     * Placeholders are written as {} or {:x}, {:X}, {:o} and {:b} for integers;
+     * {{ and }} stand for literal braces. The string is split into literal runs and
+     * argument slots when the program is compiled, and the number of placeholders and
+     * their presentations are checked against the argument types, so formatting at
+     * runtime only copies literal runs and converts the arguments.
+     */
+    template <typename... Args>
+    class format_string
+    {
+    public:
+        /**
+         * \brief Parses and checks a format string literal.
+         *
+         * \param str Format string; must be a string literal.
+         */
+        template <typename S>
+            requires std::is_convertible_v<const S &, std::string_view>
+        consteval format_string(const S &str) : str_(str)
+        {
+            std::size_t run_start = 0;
+            std::size_t args = 0;
+            const std::size_t size = str_.size();
+
+            for (std::size_t i = 0; i < size; i++)
+            {
+                const char c = str_[i];
+                if (c == '{' && i + 1 < size && str_[i + 1] == '{')
+                {
+                    // Keep the first brace, skip the second one
+                    push(run_start, i + 1 - run_start, false, '\0');
+                    run_start = i + 2;
+                    i++;
+                }
+                else if (c == '}')
+                {
+                    if (i + 1 >= size || str_[i + 1] != '}')
+                    {
+                        string_builder_format_error("unmatched '}' in format string");
+                    }
+
+                    push(run_start, i + 1 - run_start, false, '\0');
+                    run_start = i + 2;
+                    i++;
+                }
+                else if (c == '{')
+                {
+                    // Parse the placeholder
+                    char spec = '\0';
+                    std::size_t end = i + 1;
+                    if (end < size && str_[end] == ':')
+                    {
+                        if (end + 2 >= size)
+                        {
+                            string_builder_format_error("unterminated placeholder in format string");
+                        }
+
+                        spec = str_[end + 1];
+                        if (spec != 'x' && spec != 'X' && spec != 'o' && spec != 'b')
+                        {
+                            string_builder_format_error("unknown presentation in format string");
+                        }
+
+                        end += 2;
+                    }
+
+                    if (end >= size || str_[end] != '}')
+                    {
+                        string_builder_format_error("unterminated placeholder in format string");
+                    }
+
+                    if (args >= sizeof...(Args))
+                    {
+                        string_builder_format_error("more placeholders than arguments");
+                    }
+                    else if (!check_spec(args, spec))
+                    {
+                        string_builder_format_error("argument type does not match its placeholder");
+                    }
+
+                    push(run_start, i - run_start, true, spec);
+                    run_start = end + 1;
+                    i = end;
+                    args++;
+                }
+            }
+
+            if (args != sizeof...(Args))
+            {
+                string_builder_format_error("fewer placeholders than arguments");
+            }
+
+            push(run_start, size - run_start, false, '\0');
+        }
+
+        /**
+         * \brief Returns the original format string.
+         */
+        constexpr std::string_view str() const
+        {
+            return str_;
+        }
+
+        /**
+         * \brief Returns the parsed operations.
+         */
+        constexpr const string_builder_format_op_t *ops() const
+        {
+            return ops_;
+        }
+
+        /**
+         * \brief Returns the number of parsed operations.
+         */
+        constexpr std::size_t op_count() const
+        {
+            return op_count_;
+        }
+
+    private:
+        std::string_view str_;
+        string_builder_format_op_t ops_[string_builder_max_format_ops] = {};
+        std::size_t op_count_ = 0;
+
+        /**
+         * \brief Checks the presentation of the argument at \p index.
+         */
+        static consteval bool check_spec(const std::size_t index, const char spec)
+        {
+            constexpr std::size_t count = sizeof...(Args);
+            if constexpr (count == 0)
+            {
+                (void)index;
+                (void)spec;
+                return false;
+            }
+            else
+            {
+                const bool accepted[count] = { accepts_string_builder_spec<Args>(spec)... };
+                return accepted[index];
+            }
+        }
+
+        /**
+         * \brief Records a literal run, dropping empty runs that carry no argument.
+         */
+        consteval void push(const std::size_t offset, const std::size_t len, const bool has_arg, const char spec)
+        {
+            if (len == 0 && !has_arg)
+            {
+                return;
+            }
+
+            if (op_count_ >= string_builder_max_format_ops)
+            {
+                string_builder_format_error("format string is too complex");
+                return;
+            }
+
+            ops_[op_count_].offset = offset;
+            ops_[op_count_].len = len;
+            ops_[op_count_].has_arg = has_arg;
+            ops_[op_count_].spec = spec;
+            op_count_++;
+        }
+    };
+
+    /**
+     * \brief Appends a single formatted argument.
+     *
+     * \param builder Pointer to the string_builder_t.
+     * \param value Value to append.
+     * \param spec Presentation checked at compile time ('\0' for the default one).
+     */
+    template <typename T>
+    inline void write_string_builder_arg(string_builder_t *builder, const T &value, const char spec)
+    {
+        using U = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<U, bool>)
+        {
+            if (value)
+            {
+                write_string_builder_ranged(builder, "true", 4);
+            }
+            else
+            {
+                write_string_builder_ranged(builder, "false", 5);
+            }
+        }
+        else if constexpr (std::is_same_v<U, char>)
+        {
+            if (spec == '\0')
+            {
+                write_char_string_builder(builder, value);
+            }
+            else
+            {
+                write_string_builder_arg(builder, static_cast<unsigned char>(value), spec);
+            }
+        }
+        else if constexpr (std::is_integral_v<U>)
+        {
+            switch (spec)
+            {
+                case 'x': write_hex_u64_string_builder(builder, static_cast<uint64_t>(value), 0); break;
+                case 'X': write_hex_u64_string_builder(builder, static_cast<uint64_t>(value), 1); break;
+                case 'o': write_oct_u64_string_builder(builder, static_cast<uint64_t>(value)); break;
+                case 'b': write_bin_u64_string_builder(builder, static_cast<uint64_t>(value)); break;
+                default:
+                    if constexpr (std::is_signed_v<U>)
+                    {
+                        write_i64_string_builder(builder, static_cast<int64_t>(value));
+                    }
+                    else
+                    {
+                        write_u64_string_builder(builder, static_cast<uint64_t>(value));
+                    }
+                    break;
+            }
+        }
+        else if constexpr (std::is_same_v<U, float>)
+        {
+            write_float_string_builder(builder, value);
+        }
+        else if constexpr (std::is_floating_point_v<U>)
+        {
+            write_double_string_builder(builder, static_cast<double>(value));
+        }
+        else if constexpr (std::is_convertible_v<const T &, const char *> && !std::is_array_v<U>)
+        {
+            const char *str = value;
+            write_string_builder(builder, str == nullptr ? "(null)" : str);
+        }
+        else
+        {
+            const std::string_view str = value;
+            write_string_builder_ranged(builder, str.data(), str.size());
+        }
+    }
+
+    /**
+     * \brief Appends formatted output using a format string parsed at compile time.
+     *
+     * \code
+     * fluent::format(&builder, "{} = {:x}\n", name, value);
+     * \endcode
+     *
+     * \param builder Pointer to the string_builder_t.
+     * \param fmt Format string, checked against \p args at compile time.
+     * \param args Arguments to append.
+     */
+    template <typename... Args>
+    inline void format(string_builder_t *builder, format_string<std::type_identity_t<Args>...> fmt, const Args &... args)
+    {
+        const char *base = fmt.str().data();
+        const string_builder_format_op_t *ops = fmt.ops();
+        const std::size_t count = fmt.op_count();
+        std::size_t op = 0;
+
+        // Copy literal runs up to and including the one that precedes each argument
+        const auto write_until_arg = [&]() -> char
+        {
+            while (op < count)
+            {
+                const string_builder_format_op_t &current = ops[op++];
+                if (current.len > 0)
+                {
+                    write_string_builder_ranged(builder, base + current.offset, current.len);
+                }
+
+                if (current.has_arg)
+                {
+                    return current.spec;
+                }
+            }
+
+            return '\0';
+        };
+
+        (write_string_builder_arg(builder, args, write_until_arg()), ...);
+
+        // Copy the trailing literal runs
+        write_until_arg();
+    }
+}
+
+#endif //FLUENT_LIBC_STRING_BUILDER_HPP
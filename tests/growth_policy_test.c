@@ -0,0 +1,135 @@
+/*
+    The Fluent Programming Language
+    -----------------------------------------------------
+    This code is released under the GNU GPL v3 license.
+    For more information, please visit:
+    https://www.gnu.org/licenses/gpl-3.0.html
+    -----------------------------------------------------
+    Copyright (c) 2025 Rodrigo R. & All Fluent Contributors
+    This program comes with ABSOLUTELY NO WARRANTY.
+    For details type `fluent l`. This is free software,
+    and you are welcome to redistribute it under certain
+    conditions; type `fluent l -f` for details.
+*/
+
+//
+// Behavior test for the growth policy of string_builder_t.
+//
+// Small capacities with growth factors below 2 truncate back to the same
+// capacity (1 * 1.5 == 1), which must still make progress instead of looping.
+// The same capacities are reached through shrink, reserve and arena builders.
+//
+
+#include "string_builder.h"
+
+static int failures = 0;
+
+/**
+ * \brief Reports a failed expectation.
+ */
+static void expect(const int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("failed: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * \brief Checks that the builder holds exactly \p expected.
+ */
+static void expect_contents(const string_builder_t *builder, const char *expected, const char *what)
+{
+    const size_t len = strlen(expected);
+    expect(builder->idx == len && memcmp(builder->buf, expected, len) == 0, what);
+    expect(builder->capacity >= builder->idx, what);
+}
+
+int main(void)
+{
+    string_builder_t builder;
+
+    // Factors below 2 on a capacity of 1
+    const double factors[] = { 1.0, 1.1, 1.5, 1.9 };
+    for (size_t i = 0; i < sizeof(factors) / sizeof(factors[0]); i++)
+    {
+        init_string_builder(&builder, 1, factors[i]);
+        write_string_builder(&builder, "ab");
+        expect_contents(&builder, "ab", "small capacity grows past a truncated factor");
+
+        // One character at a time goes through every small capacity
+        for (int k = 0; k < 100; k++)
+        {
+            write_char_string_builder(&builder, 'c');
+        }
+
+        expect(builder.idx == 102, "character writes grow one by one");
+        destroy_string_builder(&builder);
+    }
+
+    // The factor is still applied once it makes progress
+    init_string_builder(&builder, 4, 1.5);
+    write_string_builder(&builder, "abcde");
+    expect(builder.capacity == 6, "growth factor is applied");
+    destroy_string_builder(&builder);
+
+    // Large requests are served in one step
+    init_string_builder(&builder, 2, 2.0);
+    write_repeat_string_builder(&builder, 'x', 1000);
+    expect(builder.idx == 1000 && builder.capacity >= 1000, "large request grows once");
+    destroy_string_builder(&builder);
+
+    // Shrinking leaves a small capacity that must grow again
+    init_string_builder(&builder, 64, 1.5);
+    write_char_string_builder(&builder, 'x');
+    shrink_string_builder(&builder);
+    expect(builder.capacity == 1, "shrink fits the contents");
+    write_string_builder(&builder, "yz");
+    expect_contents(&builder, "xyz", "write after shrink");
+    shrink_string_builder(&builder);
+    expect(builder.capacity == 3, "shrink again");
+    destroy_string_builder(&builder);
+
+    // Shrinking an empty builder
+    init_string_builder(&builder, 16, 1.5);
+    shrink_string_builder(&builder);
+    write_string_builder(&builder, "abc");
+    expect_contents(&builder, "abc", "write after shrinking to zero");
+    destroy_string_builder(&builder);
+
+    // Reserve is exact and never shrinks
+    init_string_builder(&builder, 1, 1.5);
+    reserve_string_builder(&builder, 10);
+    expect(builder.capacity == 10, "reserve resizes exactly");
+    reserve_string_builder(&builder, 4);
+    expect(builder.capacity == 10, "reserve never shrinks");
+    write_string_builder(&builder, "abc");
+    reserve_additional_string_builder(&builder, 20);
+    expect(builder.capacity == 23, "reserve_additional counts from the index");
+    shrink_string_builder(&builder);
+    write_string_builder(&builder, "de");
+    expect_contents(&builder, "abcde", "write after reserve and shrink");
+    destroy_string_builder(&builder);
+
+    // Arena builders with a capacity of 1
+    string_builder_arena_t arena;
+    init_string_builder_arena(&arena, 256);
+    init_string_builder_in_arena(&builder, &arena, 1, 1.5);
+    write_string_builder(&builder, "ab");
+    for (int k = 0; k < 100; k++)
+    {
+        write_char_string_builder(&builder, 'c');
+    }
+
+    expect(builder.idx == 102 && memcmp(builder.buf, "abccc", 5) == 0, "arena builder grows from 1");
+    destroy_string_builder_arena(&arena);
+
+    if (failures > 0)
+    {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+    The Fluent Programming Language
+    -----------------------------------------------------
+    This code is released under the GNU GPL v3 license.
+    For more information, please visit:
+    https://www.gnu.org/licenses/gpl-3.0.html
+    -----------------------------------------------------
+    Copyright (c) 2025 Rodrigo R. & All Fluent Contributors
+    This program comes with ABSOLUTELY NO WARRANTY.
+    For details type `fluent l`. This is free software,
+    and you are welcome to redistribute it under certain
+    conditions; type `fluent l -f` for details.
+*/
+
+//
+// Round-trip test for write_double_string_builder and write_float_string_builder.
+//
+// Every printed value must parse back to the same bits, must be the closest
+// decimal with that many significant digits, and must not have a shorter
+// representation that also parses back. Built once with 128-bit integers and
+// once with STRING_BUILDER_NO_INT128 to cover both multiplication paths.
+// Usage: ryu_round_trip_test [count] (random values per type, default 200000).
+//
+
+#include "string_builder.h"
+
+static uint64_t state = 0x9E3779B97F4A7C15ull;
+static int failures = 0;
+
+/**
+ * \brief Returns the next value of a xorshift64* generator.
+ */
+static uint64_t next_random(void)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+/**
+ * \brief Extracts the significant digits of a decimal string.
+ *
+ * \param str Number in plain or exponential notation.
+ * \param digits Destination for the digits, without leading or trailing zeros.
+ * \return Number of digits written.
+ */
+static size_t significant_digits(const char *str, char *digits)
+{
+    size_t len = 0;
+    for (; *str != '\0' && *str != 'e' && *str != 'E'; str++)
+    {
+        if (*str >= '0' && *str <= '9' && (len > 0 || *str != '0'))
+        {
+            digits[len++] = *str;
+        }
+    }
+
+    while (len > 1 && digits[len - 1] == '0')
+    {
+        len--;
+    }
+
+    digits[len] = '\0';
+    return len;
+}
+
+/**
+ * \brief Reports a failure for a value.
+ */
+static void fail(const char *type, const uint64_t bits, const char *printed, const char *reason)
+{
+    if (failures < 20)
+    {
+        printf("%s 0x%016llx printed as %s: %s\n", type, (unsigned long long)bits, printed, reason);
+    }
+
+    failures++;
+}
+
+/**
+ * \brief Checks the printed form of a finite double.
+ */
+static void check_double(string_builder_t *builder, const uint64_t bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    if (value != value || value - value != 0)
+    {
+        return;
+    }
+
+    reset_string_builder(builder);
+    write_double_string_builder(builder, value);
+    const char *printed = collect_string_builder_no_copy(builder);
+
+    // Round trip
+    const double parsed = strtod(printed, NULL);
+    if (memcmp(&parsed, &value, sizeof(value)) != 0)
+    {
+        fail("double", bits, printed, "does not round-trip");
+        return;
+    }
+
+    char digits[32];
+    const size_t count = significant_digits(printed, digits);
+
+    // Closest: the correctly rounded decimal with as many digits. Skipped for
+    // powers of two, whose lower neighbour is only half an ulp away.
+    char expected[64];
+    char expected_digits[32];
+    snprintf(expected, sizeof(expected), "%.*e", (int)count - 1, value);
+    significant_digits(expected, expected_digits);
+    if ((bits & 0xFFFFFFFFFFFFFull) != 0 && strcmp(digits, expected_digits) != 0)
+    {
+        fail("double", bits, printed, "is not the closest decimal");
+        return;
+    }
+
+    // Shortest: one digit less must not round-trip
+    if (count > 1)
+    {
+        char shorter[64];
+        snprintf(shorter, sizeof(shorter), "%.*e", (int)count - 2, value);
+        if (strtod(shorter, NULL) == value)
+        {
+            fail("double", bits, printed, "is not the shortest decimal");
+        }
+    }
+}
+
+/**
+ * \brief Checks the printed form of a finite float.
+ */
+static void check_float(string_builder_t *builder, const uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    if (value != value || value - value != 0)
+    {
+        return;
+    }
+
+    reset_string_builder(builder);
+    write_float_string_builder(builder, value);
+    const char *printed = collect_string_builder_no_copy(builder);
+
+    // Round trip
+    const float parsed = strtof(printed, NULL);
+    if (memcmp(&parsed, &value, sizeof(value)) != 0)
+    {
+        fail("float", bits, printed, "does not round-trip");
+        return;
+    }
+
+    char digits[32];
+    const size_t count = significant_digits(printed, digits);
+
+    // Closest: the correctly rounded decimal with as many digits. Skipped for
+    // powers of two, whose lower neighbour is only half an ulp away.
+    char expected[64];
+    char expected_digits[32];
+    snprintf(expected, sizeof(expected), "%.*e", (int)count - 1, (double)value);
+    significant_digits(expected, expected_digits);
+    if ((bits & 0x7FFFFF) != 0 && strcmp(digits, expected_digits) != 0)
+    {
+        fail("float", bits, printed, "is not the closest decimal");
+        return;
+    }
+
+    // Shortest: one digit less must not round-trip
+    if (count > 1)
+    {
+        char shorter[64];
+        snprintf(shorter, sizeof(shorter), "%.*e", (int)count - 2, (double)value);
+        if (strtof(shorter, NULL) == value)
+        {
+            fail("float", bits, printed, "is not the shortest decimal");
+        }
+    }
+}
+
+int main(const int argc, char **argv)
+{
+    const long count = argc > 1 ? strtol(argv[1], NULL, 10) : 200000;
+
+    string_builder_t builder;
+    init_string_builder(&builder, 64, 2.0);
+
+    // Boundaries: zeros, subnormals, powers of two and the largest values
+    for (uint64_t exponent = 0; exponent < 2047; exponent++)
+    {
+        check_double(&builder, exponent << 52);
+        check_double(&builder, exponent << 52 | 1);
+        check_double(&builder, exponent << 52 | 0xFFFFFFFFFFFFFull);
+    }
+
+    for (uint32_t exponent = 0; exponent < 255; exponent++)
+    {
+        check_float(&builder, exponent << 23);
+        check_float(&builder, exponent << 23 | 1);
+        check_float(&builder, exponent << 23 | 0x7FFFFF);
+    }
+
+    // Random bit patterns
+    for (long i = 0; i < count; i++)
+    {
+        const uint64_t bits = next_random();
+        check_double(&builder, bits);
+        check_float(&builder, (uint32_t)(bits >> 32));
+    }
+
+    // Small integers and short decimals
+    for (int i = 0; i < 100000; i++)
+    {
+        const double value = i / 1000.0;
+        const float single = (float)value;
+        uint64_t bits;
+        uint32_t single_bits;
+        memcpy(&bits, &value, sizeof(bits));
+        memcpy(&single_bits, &single, sizeof(single_bits));
+        check_double(&builder, bits);
+        check_float(&builder, single_bits);
+    }
+
+    destroy_string_builder(&builder);
+
+    if (failures > 0)
+    {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}